@@ -0,0 +1,130 @@
+#include "Allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Constant-initialized, so allocations made before main() are counted too
+static std::atomic<uint64_t> allocationCount[Allocations::maxSubsystems];
+static std::atomic<uint64_t> allocationBytes[Allocations::maxSubsystems];
+static thread_local int currentSubsystem = Allocations::otherThreads;
+static const char* subsystemNames[Allocations::maxSubsystems];
+
+bool Allocations::tracked() {
+#ifdef CELTIC_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Allocations::name(int subsystem, const char* label) {
+    if (subsystem >= 0 && subsystem < maxSubsystems) subsystemNames[subsystem] = label;
+}
+
+const char* Allocations::name(int subsystem) {
+    if (subsystem < 0 || subsystem >= maxSubsystems) return "";
+    if (subsystemNames[subsystem]) return subsystemNames[subsystem];
+    return subsystem == otherThreads ? "other threads" : "";
+}
+
+void Allocations::enter(int subsystem) {
+    if (subsystem >= 0 && subsystem < maxSubsystems) currentSubsystem = subsystem;
+}
+
+AllocationCounts Allocations::total(int subsystem) {
+    AllocationCounts counts;
+    if (subsystem < 0 || subsystem >= maxSubsystems) return counts;
+    counts.allocations = allocationCount[subsystem].load(std::memory_order_relaxed);
+    counts.bytes = allocationBytes[subsystem].load(std::memory_order_relaxed);
+    return counts;
+}
+
+AllocationCounts Allocations::total() {
+    AllocationCounts counts;
+    for (int s = 0; s < maxSubsystems; ++s) {
+        AllocationCounts part = total(s);
+        counts.allocations += part.allocations;
+        counts.bytes += part.bytes;
+    }
+    return counts;
+}
+
+size_t Allocations::peakResidentBytes() {
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss); // bytes
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+#else
+    return 0;
+#endif
+}
+
+#ifdef CELTIC_TRACK_ALLOCATIONS
+
+static void countAllocation(size_t size) {
+    allocationCount[currentSubsystem].fetch_add(1, std::memory_order_relaxed);
+    allocationBytes[currentSubsystem].fetch_add(size, std::memory_order_relaxed);
+}
+
+static void* allocate(size_t size, size_t alignment) {
+    if (size == 0) size = 1;
+    void* p;
+#ifdef _WIN32
+    p = alignment ? _aligned_malloc(size, alignment) : std::malloc(size);
+#else
+    p = alignment ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment) : std::malloc(size);
+#endif
+    if (p) countAllocation(size);
+    return p;
+}
+
+static void release(void* p, bool aligned) {
+#ifdef _WIN32
+    if (aligned) {
+        _aligned_free(p);
+        return;
+    }
+#else
+    (void)aligned;
+#endif
+    std::free(p);
+}
+
+void* operator new(size_t size) {
+    if (void* p = allocate(size, 0)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    if (void* p = allocate(size, 0)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* p = allocate(size, static_cast<size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+    if (void* p = allocate(size, static_cast<size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { release(p, false); }
+void operator delete[](void* p) noexcept { release(p, false); }
+void operator delete(void* p, size_t) noexcept { release(p, false); }
+void operator delete[](void* p, size_t) noexcept { release(p, false); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p, true); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p, true); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { release(p, true); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { release(p, true); }
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+// Heap allocation counts per subsystem, for catching allocations that creep
+// into the interactive loop. Built with -DCELTIC_TRACK_ALLOCATIONS, the
+// global operator new and delete are replaced by counting versions (one
+// relaxed atomic add each); otherwise nothing is counted and tracked() is
+// false. A thread charges its allocations to the subsystem it last entered;
+// threads that never enter one are charged to "other threads".
+//
+//   Allocations::name(0, "events");  Allocations::enter(0);
+//   AllocationCounts seen = Allocations::total(0);
+
+#include <cstddef>
+#include <cstdint>
+
+struct AllocationCounts {
+    uint64_t allocations = 0, bytes = 0;
+
+    AllocationCounts operator-(const AllocationCounts& earlier) const {
+        return {allocations - earlier.allocations, bytes - earlier.bytes};
+    }
+};
+
+class Allocations {
+public:
+    static constexpr int maxSubsystems = 16;
+    static constexpr int otherThreads = maxSubsystems - 1;
+
+    static bool tracked();
+
+    // Label for reports; 'label' must be a literal
+    static void name(int subsystem, const char* label);
+    static const char* name(int subsystem);
+    // Charge the calling thread's allocations to 'subsystem' from now on
+    static void enter(int subsystem);
+
+    // Since the program started
+    static AllocationCounts total(int subsystem);
+    static AllocationCounts total();
+
+    // Largest resident set so far, in bytes (0 where unknown)
+    static size_t peakResidentBytes();
+};
@@ -0,0 +1,224 @@
+#include "Backends.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cctype>
+#include <cstdint>
+
+SfmlWindow::SfmlWindow(int width, int height, const std::string& title) : window(sf::VideoMode(width, height), title) {}
+
+// The texture is only recreated when the size changes; frames are uploaded into it
+void SfmlWindow::setFrame(const sf::Uint8* rgba, unsigned width, unsigned height) {
+    if (texture.getSize() != sf::Vector2u(width, height)) {
+        texture.create(width, height);
+        sprite.setTexture(texture, true);
+    }
+    texture.update(rgba);
+}
+
+void SfmlWindow::beginFrame() {
+    window.clear();
+    window.draw(sprite);
+}
+
+// A letter, a digit, LAlt or RAlt
+bool keyFromName(const std::string& name, sf::Keyboard::Key& key) {
+    if (name.size() == 1 && std::isalpha(static_cast<unsigned char>(name[0]))) {
+        key = static_cast<sf::Keyboard::Key>(sf::Keyboard::A + (std::toupper(static_cast<unsigned char>(name[0])) - 'A'));
+    } else if (name.size() == 1 && std::isdigit(static_cast<unsigned char>(name[0]))) {
+        key = static_cast<sf::Keyboard::Key>(sf::Keyboard::Num0 + (name[0] - '0'));
+    } else if (name == "LAlt") {
+        key = sf::Keyboard::LAlt;
+    } else if (name == "RAlt") {
+        key = sf::Keyboard::RAlt;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Inverse of keyFromName; false for keys a script cannot name
+bool keyToName(sf::Keyboard::Key key, std::string& name) {
+    if (key >= sf::Keyboard::A && key <= sf::Keyboard::Z) {
+        name = std::string(1, static_cast<char>('A' + (key - sf::Keyboard::A)));
+    } else if (key >= sf::Keyboard::Num0 && key <= sf::Keyboard::Num9) {
+        name = std::string(1, static_cast<char>('0' + (key - sf::Keyboard::Num0)));
+    } else if (key == sf::Keyboard::LAlt) {
+        name = "LAlt";
+    } else if (key == sf::Keyboard::RAlt) {
+        name = "RAlt";
+    } else {
+        return false;
+    }
+    return true;
+}
+
+NullWindow::NullWindow(const std::string& scriptPath, double frameStepMs) : frameStep(frameStepMs) {
+    std::ifstream in(scriptPath);
+    if (!in) std::cerr << "Cannot open input script " << scriptPath << std::endl;
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        ScriptEvent scripted;
+        std::string name, argument;
+        if (!(fields >> scripted.time >> name)) continue;
+        sf::Event& event = scripted.event;
+        bool valid = true;
+        if (name == "move") {
+            event.type = sf::Event::MouseMoved;
+            valid = static_cast<bool>(fields >> event.mouseMove.x >> event.mouseMove.y);
+        } else if (name == "press" || name == "release") {
+            event.type = name == "press" ? sf::Event::MouseButtonPressed : sf::Event::MouseButtonReleased;
+            valid = static_cast<bool>(fields >> argument) && (argument == "left" || argument == "right");
+            event.mouseButton.button = argument == "right" ? sf::Mouse::Right : sf::Mouse::Left;
+        } else if (name == "wheel") {
+            event.type = sf::Event::MouseWheelScrolled;
+            event.mouseWheelScroll.wheel = sf::Mouse::VerticalWheel;
+            valid = static_cast<bool>(fields >> event.mouseWheelScroll.delta);
+        } else if (name == "keydown" || name == "keyup") {
+            event.type = name == "keydown" ? sf::Event::KeyPressed : sf::Event::KeyReleased;
+            valid = static_cast<bool>(fields >> argument) && keyFromName(argument, event.key.code);
+        } else if (name == "focus-lost") {
+            event.type = sf::Event::LostFocus;
+        } else if (name == "close") {
+            event.type = sf::Event::Closed;
+        } else {
+            valid = false;
+        }
+        if (valid) {
+            script.push_back(scripted);
+        } else {
+            std::cerr << scriptPath << ":" << number << ": skipped, not an input event" << std::endl;
+        }
+    }
+}
+
+sf::Time NullWindow::elapsed() const {
+    if (frameStep > 0) return sf::microseconds(static_cast<sf::Int64>(displayed * frameStep * 1000));
+    return clock.getElapsedTime();
+}
+
+bool NullWindow::pollEvent(sf::Event& event) {
+    if (next == script.size()) {
+        if (closeSent) return false;
+        closeSent = true;
+        event.type = sf::Event::Closed;
+        return true;
+    }
+    if (elapsed().asMicroseconds() < script[next].time * sf::Int64(1000)) return false;
+    event = script[next++].event;
+
+    // Live state follows the events, the way a real window reports it
+    bool alt = keys[sf::Keyboard::LAlt] || keys[sf::Keyboard::RAlt];
+    switch (event.type) {
+    case sf::Event::MouseMoved:
+        mouse = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+        break;
+    case sf::Event::MouseButtonPressed:
+    case sf::Event::MouseButtonReleased:
+        buttons[event.mouseButton.button] = event.type == sf::Event::MouseButtonPressed;
+        event.mouseButton.x = mouse.x;
+        event.mouseButton.y = mouse.y;
+        break;
+    case sf::Event::MouseWheelScrolled:
+        event.mouseWheelScroll.x = mouse.x;
+        event.mouseWheelScroll.y = mouse.y;
+        break;
+    case sf::Event::KeyPressed:
+    case sf::Event::KeyReleased:
+        keys[event.key.code] = event.type == sf::Event::KeyPressed;
+        event.key.alt = alt;
+        event.key.control = event.key.shift = event.key.system = false;
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+bool NullWindow::isKeyPressed(sf::Keyboard::Key key) const {
+    return key >= 0 && key < sf::Keyboard::KeyCount && keys[key];
+}
+
+bool NullWindow::isButtonPressed(sf::Mouse::Button button) const {
+    return button >= 0 && button < sf::Mouse::ButtonCount && buttons[button];
+}
+
+RecordingWindow::RecordingWindow(std::unique_ptr<WindowBackend> inner, const std::string& scriptPath)
+    : inner(std::move(inner)), script(scriptPath) {
+    if (!script) std::cerr << "Cannot write input script " << scriptPath << std::endl;
+    script << "# celticorbitexplorer session; replay with --null-window" << std::endl;
+}
+
+bool RecordingWindow::pollEvent(sf::Event& event) {
+    if (!inner->pollEvent(event)) return false;
+    std::ostringstream line;
+    std::string key;
+    switch (event.type) {
+    case sf::Event::MouseMoved:
+        line << "move " << event.mouseMove.x << " " << event.mouseMove.y;
+        break;
+    case sf::Event::MouseButtonPressed:
+    case sf::Event::MouseButtonReleased:
+        if (event.mouseButton.button != sf::Mouse::Left && event.mouseButton.button != sf::Mouse::Right) break;
+        line << (event.type == sf::Event::MouseButtonPressed ? "press " : "release ")
+             << (event.mouseButton.button == sf::Mouse::Left ? "left" : "right");
+        break;
+    case sf::Event::MouseWheelScrolled:
+        line << "wheel " << event.mouseWheelScroll.delta;
+        break;
+    case sf::Event::KeyPressed:
+    case sf::Event::KeyReleased:
+        if (keyToName(event.key.code, key)) line << (event.type == sf::Event::KeyPressed ? "keydown " : "keyup ") << key;
+        break;
+    case sf::Event::LostFocus:
+        line << "focus-lost";
+        break;
+    case sf::Event::Closed:
+        line << "close";
+        break;
+    default:
+        break;
+    }
+    if (!line.str().empty()) script << clock.getElapsedTime().asMilliseconds() << " " << line.str() << "\n";
+    return true;
+}
+
+void SpeakerSink::play(const std::vector<sf::Int16>& samples, unsigned sampleRate) {
+    buffer.loadFromSamples(samples.data(), samples.size(), 1, sampleRate);
+    sound.setBuffer(buffer);
+    sound.play();
+}
+
+void WavAudioSink::play(const std::vector<sf::Int16>& samples, unsigned sampleRate) {
+    if (rate == 0) rate = sampleRate;
+    // Silence up to now, or the cut-off tail of the previous tone
+    timeline.resize(static_cast<size_t>(window.elapsed().asMicroseconds() * rate / 1000000));
+    timeline.insert(timeline.end(), samples.begin(), samples.end());
+}
+
+WavAudioSink::~WavAudioSink() {
+    std::ofstream out(path, std::ios::binary);
+    auto put = [&](uint32_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) out.put(static_cast<char>(value >> (8 * i)));
+    };
+    uint32_t dataSize = static_cast<uint32_t>(timeline.size() * 2);
+    uint32_t sampleRate = rate ? rate : 44100;
+    out.write("RIFF", 4);
+    put(36 + dataSize, 4);
+    out.write("WAVEfmt ", 8);
+    put(16, 4);             // fmt chunk size
+    put(1, 2);              // PCM
+    put(1, 2);              // mono
+    put(sampleRate, 4);
+    put(sampleRate * 2, 4); // bytes per second
+    put(2, 2);              // block align
+    put(16, 2);             // bits per sample
+    out.write("data", 4);
+    put(dataSize, 4);
+    for (sf::Int16 sample : timeline) put(static_cast<uint16_t>(sample), 2);
+    if (out) std::cout << "Wrote " << timeline.size() << " audio samples to " << path << std::endl;
+    else std::cerr << "Failed to write " << path << std::endl;
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+// Window and audio backends for the explorer. The loop talks to these instead
+// of SFML directly, so it also runs on machines without a display or sound
+// card: the null window replays scripted input and draws nothing, and the WAV
+// sink records the tones instead of playing them.
+
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class WindowBackend {
+public:
+    virtual ~WindowBackend() {}
+
+    virtual bool isOpen() const = 0;
+    virtual void close() = 0;
+    virtual bool pollEvent(sf::Event& event) = 0;
+    virtual sf::Vector2i mousePosition() const = 0;
+    virtual bool isKeyPressed(sf::Keyboard::Key key) const = 0;
+    virtual bool isButtonPressed(sf::Mouse::Button button) const = 0;
+
+    // A newly computed fractal frame, opaque RGBA
+    virtual void setFrame(const sf::Uint8* rgba, unsigned width, unsigned height) = 0;
+    // Clears to the fractal frame; overlays are drawn on top until display()
+    virtual void beginFrame() = 0;
+    virtual void draw(const sf::Drawable& drawable) = 0;
+    virtual void display() = 0;
+
+    // Time since the window was created, on the clock its input runs on
+    virtual sf::Time elapsed() const = 0;
+};
+
+class SfmlWindow : public WindowBackend {
+public:
+    SfmlWindow(int width, int height, const std::string& title);
+
+    bool isOpen() const override { return window.isOpen(); }
+    void close() override { window.close(); }
+    bool pollEvent(sf::Event& event) override { return window.pollEvent(event); }
+    sf::Vector2i mousePosition() const override { return sf::Mouse::getPosition(window); }
+    bool isKeyPressed(sf::Keyboard::Key key) const override { return sf::Keyboard::isKeyPressed(key); }
+    bool isButtonPressed(sf::Mouse::Button button) const override { return sf::Mouse::isButtonPressed(button); }
+
+    void setFrame(const sf::Uint8* rgba, unsigned width, unsigned height) override;
+    void beginFrame() override;
+    void draw(const sf::Drawable& drawable) override { window.draw(drawable); }
+    void display() override { window.display(); }
+
+    sf::Time elapsed() const override { return clock.getElapsedTime(); }
+
+private:
+    sf::RenderWindow window;
+    sf::Clock clock;
+    sf::Texture texture;
+    sf::Sprite sprite;
+};
+
+// Replays an input script, one "milliseconds event [arguments]" per line
+// ('#' starts a comment), timed from the window's creation:
+//   move X Y | press left|right | release left|right | wheel DELTA
+//   keydown KEY | keyup KEY | focus-lost | close
+// KEY is a letter, a digit, LAlt or RAlt. The window closes after the last event.
+// With a frame step the script runs on a virtual clock that advances by that
+// many milliseconds per displayed frame, so every replay handles each event
+// in the same frame however long the frames really take.
+class NullWindow : public WindowBackend {
+public:
+    explicit NullWindow(const std::string& scriptPath, double frameStepMs = 0);
+
+    bool isOpen() const override { return open; }
+    void close() override { open = false; }
+    bool pollEvent(sf::Event& event) override;
+    sf::Vector2i mousePosition() const override { return mouse; }
+    bool isKeyPressed(sf::Keyboard::Key key) const override;
+    bool isButtonPressed(sf::Mouse::Button button) const override;
+
+    // Nothing is uploaded or drawn; overlays are still built by the caller
+    void setFrame(const sf::Uint8*, unsigned, unsigned) override {}
+    void beginFrame() override {}
+    void draw(const sf::Drawable&) override {}
+    void display() override { ++displayed; }
+
+    // The virtual clock under a frame step, otherwise real time
+    sf::Time elapsed() const override;
+
+private:
+    struct ScriptEvent {
+        int time = 0; // milliseconds
+        sf::Event event = sf::Event();
+    };
+
+    std::vector<ScriptEvent> script;
+    size_t next = 0;
+    bool closeSent = false;
+    bool open = true;
+    double frameStep;
+    long displayed = 0;
+    sf::Clock clock;
+    sf::Vector2i mouse;
+    bool keys[sf::Keyboard::KeyCount] = {};
+    bool buttons[sf::Mouse::ButtonCount] = {};
+};
+
+// Passes everything through to 'inner' and writes the input events it delivers
+// as a NullWindow script, timed from its creation, so a session can be replayed
+class RecordingWindow : public WindowBackend {
+public:
+    RecordingWindow(std::unique_ptr<WindowBackend> inner, const std::string& scriptPath);
+
+    bool isOpen() const override { return inner->isOpen(); }
+    void close() override { inner->close(); }
+    bool pollEvent(sf::Event& event) override;
+    sf::Vector2i mousePosition() const override { return inner->mousePosition(); }
+    bool isKeyPressed(sf::Keyboard::Key key) const override { return inner->isKeyPressed(key); }
+    bool isButtonPressed(sf::Mouse::Button button) const override { return inner->isButtonPressed(button); }
+
+    void setFrame(const sf::Uint8* rgba, unsigned width, unsigned height) override { inner->setFrame(rgba, width, height); }
+    void beginFrame() override { inner->beginFrame(); }
+    void draw(const sf::Drawable& drawable) override { inner->draw(drawable); }
+    void display() override { inner->display(); }
+
+    sf::Time elapsed() const override { return inner->elapsed(); }
+
+private:
+    std::unique_ptr<WindowBackend> inner;
+    std::ofstream script;
+    sf::Clock clock;
+};
+
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+    // Mono 16-bit samples; starting a tone cuts off the one still playing
+    virtual void play(const std::vector<sf::Int16>& samples, unsigned sampleRate) = 0;
+};
+
+class SpeakerSink : public AudioSink {
+public:
+    void play(const std::vector<sf::Int16>& samples, unsigned sampleRate) override;
+
+private:
+    sf::Sound sound;
+    sf::SoundBuffer buffer;
+};
+
+class NullAudioSink : public AudioSink {
+public:
+    void play(const std::vector<sf::Int16>&, unsigned) override {}
+};
+
+// Writes everything played to a WAV file when destroyed, each tone at the time
+// it started on the window's clock, so replays with a frame step give the same file
+class WavAudioSink : public AudioSink {
+public:
+    WavAudioSink(const std::string& path, const WindowBackend& window) : path(path), window(window) {}
+    ~WavAudioSink();
+    void play(const std::vector<sf::Int16>& samples, unsigned sampleRate) override;
+
+private:
+    std::string path;
+    const WindowBackend& window;
+    unsigned rate = 0;
+    std::vector<sf::Int16> timeline;
+};
@@ -0,0 +1,281 @@
+// celticbench: iteration throughput of the core's hot paths, as JSON
+//
+//   celticbench [--size 320x240] [--max-iter 256] [--repeat 3] [--threads N] [--out bench.json]
+//
+// Every formula x precision x kernel runs over three regions of that formula:
+// interior-heavy (mostly maxIter pixels), boundary-heavy (interior and escape
+// mixed) and exterior-heavy (fast escapes). The regions are picked from a
+// fixed coarse overview, so the same build always measures the same pixels and
+// two builds can be compared row by row. Also timed: the hover orbit/period
+// search, colouring, and the render over 1..N threads. Each timing is the best
+// of --repeat runs. On Linux the kernel and thread rows also carry the
+// hardware counters of that best run (cycles, instructions, IPC, L1/LLC misses,
+// branch mispredicts) when perf_event_open is permitted. Progress goes to
+// stderr, the JSON to --out or stdout.
+
+#include "FractalCore.hpp"
+#include "CommandLine.hpp"
+#include "PerfCounters.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+
+struct BenchRegion {
+    const char* name;
+    FractalView view;
+    double interiorFraction = 0; // of the overview cell it was picked from
+};
+
+// Splits the overview of a formula (4 x 3 units around the origin) into 8 x 6
+// cells and picks the one with the most interior, the most even mix of
+// interior and escape, and the lowest cost; each is then zoomed to fill the view.
+std::vector<BenchRegion> findRegions(int formulaIndex, int width, int height, int maxIter) {
+    const int cellPixels = 12, columns = 8, rows = 6;
+    FractalView overview;
+    overview.formulaIndex = formulaIndex;
+    overview.width = cellPixels * columns;
+    overview.height = cellPixels * rows;
+    overview.zoom = overview.width / 4.0;
+    overview.maxIter = maxIter;
+    std::vector<int> iterations;
+    renderView(overview, iterations);
+
+    struct Cell {
+        double interior = 0, cost = 0;
+    };
+    std::vector<Cell> cells(columns * rows);
+    for (int y = 0; y < overview.height; ++y) {
+        for (int x = 0; x < overview.width; ++x) {
+            Cell& cell = cells[(y / cellPixels) * columns + x / cellPixels];
+            int iter = iterations[static_cast<size_t>(y) * overview.width + x];
+            cell.interior += iter >= maxIter;
+            cell.cost += iter + 1;
+        }
+    }
+    for (Cell& cell : cells) cell.interior /= cellPixels * cellPixels;
+
+    // First cell wins ties, so the choice is stable; each region gets a cell of its own
+    std::vector<bool> taken(cells.size(), false);
+    auto pick = [&](const std::function<double(const Cell&)>& score) {
+        int best = -1;
+        for (int i = 0; i < static_cast<int>(cells.size()); ++i) {
+            if (!taken[i] && (best < 0 || score(cells[i]) > score(cells[best]))) best = i;
+        }
+        taken[best] = true;
+        return best;
+    };
+    int interior = pick([](const Cell& c) { return c.interior; });
+    int exterior = pick([](const Cell& c) { return -c.cost; });
+    int boundary = pick([](const Cell& c) { return c.interior * (1 - c.interior) + c.cost * 1e-12; });
+
+    std::vector<BenchRegion> regions;
+    const char* names[3] = {"interior", "boundary", "exterior"};
+    int chosen[3] = {interior, boundary, exterior};
+    for (int r = 0; r < 3; ++r) {
+        int cx = chosen[r] % columns, cy = chosen[r] / columns;
+        BenchRegion region;
+        region.name = names[r];
+        region.view.formulaIndex = formulaIndex;
+        region.view.width = width;
+        region.view.height = height;
+        region.view.maxIter = maxIter;
+        region.view.center = pixelToComplex(overview, (cx + 0.5) * cellPixels, (cy + 0.5) * cellPixels);
+        region.view.zoom = overview.zoom * width / cellPixels;
+        region.interiorFraction = cells[chosen[r]].interior;
+        regions.push_back(region);
+    }
+    return regions;
+}
+
+// Best wall time of 'repeat' runs, and the counters of that run when asked for
+double bestSeconds(int repeat, const std::function<void()>& run, const PerfCounters* counters = nullptr,
+                   PerfCounters::Sample* bestCounters = nullptr) {
+    double best = 1e300;
+    for (int i = 0; i < std::max(repeat, 1); ++i) {
+        PerfCounters::Sample before;
+        if (counters) before = counters->read();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds < best && counters && bestCounters) *bestCounters = counters->read() - before;
+        best = std::min(best, seconds);
+    }
+    return best;
+}
+
+// ", "counters": {...}" with the counters that were read, or nothing
+std::string countersJson(const PerfCounters::Sample& sample) {
+    if (!sample.any()) return "";
+    std::ostringstream json;
+    json << std::setprecision(6) << ", \"counters\": {";
+    bool first = true;
+    for (int c = 0; c < PerfCounters::CounterCount; ++c) {
+        if (!sample.valid[c]) continue;
+        json << (first ? "" : ", ") << "\"" << PerfCounters::name(static_cast<PerfCounters::Counter>(c)) << "\": " << sample.value[c];
+        first = false;
+    }
+    if (sample.ipc() > 0) json << ", \"ipc\": " << sample.ipc();
+    json << "}";
+    return json.str();
+}
+
+const char* precisionName(Precision precision) {
+    return precision == Precision::Float ? "float" : "double";
+}
+
+const char* kernelName(Kernel kernel) {
+    return kernel == Kernel::Reference ? "reference" : "scalar";
+}
+
+int main(int argc, char** argv) {
+    CommandLine args(argc, argv, 1);
+    FractalView sizeView = viewFromCommandLine(args);
+    int width = args.has("size") ? sizeView.width : 320;
+    int height = args.has("size") ? sizeView.height : 240;
+    int maxIter = args.getInt("max-iter", 256);
+    int repeat = args.getInt("repeat", 3);
+    int maxThreads = std::max(args.getInt("threads", renderThreadCount()), 1);
+    const Kernel kernels[] = {Kernel::Reference, Kernel::Scalar};
+    const Precision precisions[] = {Precision::Float, Precision::Double};
+    // Before any pool, so its threads are counted
+    PerfCounters counters;
+    if (!counters.available()) std::cerr << "No hardware counters: " << counters.reason() << std::endl;
+
+    std::ostringstream json;
+    json << std::setprecision(6);
+    json << "{\n  \"benchmark\": \"celticbench\",\n  \"compiler\": \"" << __VERSION__ << "\",\n"
+         << "  \"hardwareThreads\": " << renderThreadCount() << ",\n  \"threads\": " << maxThreads << ",\n"
+         << "  \"size\": [" << width << ", " << height << "],\n  \"maxIter\": " << maxIter << ",\n  \"repeat\": " << repeat << ",\n";
+    json << "  \"counters\": " << (counters.available() ? "true" : "false");
+    if (!counters.available()) json << ",\n  \"countersUnavailable\": \"" << counters.reason() << "\"";
+    json << ",\n";
+
+    std::vector<std::vector<BenchRegion>> regions;
+    bool first = true;
+    json << "  \"regions\": [";
+    for (int f = 0; f < formulaCount; ++f) {
+        regions.push_back(findRegions(f, width, height, maxIter));
+        for (const BenchRegion& region : regions.back()) {
+            json << (first ? "\n" : ",\n") << "    {\"formula\": " << f + 1
+                 << ", \"region\": \"" << region.name << "\", \"center\": [" << region.view.center.real() << ", "
+                 << region.view.center.imag() << "], \"zoom\": " << region.view.zoom
+                 << ", \"interiorFraction\": " << region.interiorFraction << "}";
+            first = false;
+        }
+    }
+    json << "\n  ],\n";
+
+    // Formula x precision x kernel x region on all threads
+    TaskPool pool(maxThreads - 1); // plus the calling thread
+    std::vector<int> iterations(static_cast<size_t>(width) * height);
+    first = true;
+    json << "  \"kernels\": [";
+    for (int f = 0; f < formulaCount; ++f) {
+        for (Precision precision : precisions) {
+            for (Kernel kernel : kernels) {
+                for (const BenchRegion& region : regions[f]) {
+                    FractalView view = region.view;
+                    view.precision = precision;
+                    uint64_t cost = 0;
+                    PerfCounters::Sample sample;
+                    double seconds = bestSeconds(repeat, [&] { cost = renderInto(view, kernel, iterations.data(), width, &pool); },
+                                                 &counters, &sample);
+                    double miter = cost / 1e6 / seconds;
+                    std::cerr << "formula " << f + 1 << " " << precisionName(precision) << " " << kernelName(kernel) << " "
+                              << region.name << ": " << miter << " Miter/s";
+                    if (sample.ipc() > 0) std::cerr << ", IPC " << sample.ipc();
+                    std::cerr << std::endl;
+                    json << (first ? "\n" : ",\n") << "    {\"formula\": " << f + 1 << ", \"precision\": \"" << precisionName(precision)
+                         << "\", \"kernel\": \"" << kernelName(kernel) << "\", \"region\": \"" << region.name
+                         << "\", \"threads\": " << maxThreads << ", \"iterations\": " << cost << ", \"seconds\": " << seconds
+                         << ", \"miterPerSecond\": " << miter << countersJson(sample) << "}";
+                    first = false;
+                }
+            }
+        }
+    }
+    json << "\n  ],\n";
+
+    // Scaling of the default path over the boundary regions, 1, 2, 4, ... N threads
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    first = true;
+    json << "  \"threadScan\": [";
+    for (int f = 0; f < formulaCount; ++f) {
+        double singleThread = 0;
+        for (int threads : threadCounts) {
+            TaskPool scanPool(threads - 1); // plus the calling thread, so the 1-thread row is serial
+            uint64_t cost = 0;
+            PerfCounters::Sample sample;
+            double seconds = bestSeconds(repeat, [&] { cost = renderInto(regions[f][1].view, Kernel::Scalar, iterations.data(), width, &scanPool); },
+                                         &counters, &sample);
+            if (threads == 1) singleThread = seconds;
+            std::cerr << "formula " << f + 1 << " boundary, " << threads << " threads: " << cost / 1e6 / seconds << " Miter/s" << std::endl;
+            json << (first ? "\n" : ",\n") << "    {\"formula\": " << f + 1 << ", \"region\": \"boundary\", \"threads\": " << threads
+                 << ", \"seconds\": " << seconds << ", \"miterPerSecond\": " << cost / 1e6 / seconds
+                 << ", \"speedup\": " << singleThread / seconds << countersJson(sample) << "}";
+            first = false;
+        }
+    }
+    json << "\n  ],\n";
+
+    // Hover orbit/period search at a 32 x 24 grid of points in each region
+    const int orbitColumns = 32, orbitRows = 24, maxOrbit = 1000;
+    first = true;
+    json << "  \"orbit\": [";
+    for (int f = 0; f < formulaCount; ++f) {
+        for (Precision precision : precisions) {
+            for (const BenchRegion& region : regions[f]) {
+                FractalView view = region.view;
+                view.precision = precision;
+                std::vector<std::complex<double>> orbit;
+                long periods = 0;
+                double seconds = bestSeconds(repeat, [&] {
+                    periods = 0;
+                    for (int y = 0; y < orbitRows; ++y) {
+                        for (int x = 0; x < orbitColumns; ++x) {
+                            std::complex<double> c = pixelToComplex(view, (x + 0.5) * width / orbitColumns, (y + 0.5) * height / orbitRows);
+                            periods += findOrbitPeriod(view, c, maxOrbit, orbit);
+                        }
+                    }
+                });
+                int calls = orbitColumns * orbitRows;
+                json << (first ? "\n" : ",\n") << "    {\"formula\": " << f + 1 << ", \"precision\": \"" << precisionName(precision)
+                     << "\", \"region\": \"" << region.name << "\", \"calls\": " << calls << ", \"maxOrbit\": " << maxOrbit
+                     << ", \"microsPerCall\": " << seconds * 1e6 / calls << ", \"meanPeriod\": " << double(periods) / calls << "}";
+                first = false;
+            }
+        }
+    }
+    json << "\n  ],\n";
+
+    // Colouring of a boundary frame, single threaded as in the interactive loop
+    renderInto(regions[0][1].view, Kernel::Scalar, iterations.data(), width, &pool);
+    std::vector<uint8_t> rgba(iterations.size() * 4);
+    Palette palette = makePalette("grey");
+    double colourSeconds = bestSeconds(std::max(repeat, 10), [&] {
+        colourize(iterations.data(), iterations.size(), maxIter, 1, palette, rgba.data());
+    });
+    std::cerr << "colour: " << iterations.size() / 1e6 / colourSeconds << " Mpixel/s" << std::endl;
+    json << "  \"colour\": {\"pixels\": " << iterations.size() << ", \"seconds\": " << colourSeconds
+         << ", \"mpixelPerSecond\": " << iterations.size() / 1e6 / colourSeconds << "}\n}\n";
+
+    std::string path = args.get("out", "");
+    if (path.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream out(path);
+        out << json.str();
+        if (!out) {
+            std::cerr << "Failed to write " << path << std::endl;
+            return 1;
+        }
+        std::cerr << "Wrote " << path << std::endl;
+    }
+    return 0;
+}
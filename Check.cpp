@@ -0,0 +1,213 @@
+// celticcheck: differential check of every render path against the reference
+//
+//   celticcheck [--views 200] [--seed 1] [--mode NAME] [--show 10] [--diff-dir DIR]
+//
+// Renders randomized views (formula, Julia or not, centre, zoom, iteration
+// limit, size) with the reference kernel and with each faster path, and
+// compares the iteration buffers. Paths that must not change a single pixel
+// are checked exactly; the rest have a tolerance. Differing pixels are listed
+// (up to --show per view) and --diff-dir writes a PGM mask of each failing view.
+// Exits non-zero if any mode fails, so it can run after every build.
+
+#include "FractalCore.hpp"
+#include "CommandLine.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+// A view passes when at most maxFraction of its pixels differ and none by more than maxDelta
+struct DiffRule {
+    double maxFraction;
+    int maxDelta;
+};
+
+const DiffRule exact = {0.0, 0};
+
+struct CheckMode {
+    const char* name;
+    const char* description;
+    DiffRule rule;
+    // Iterations of the view by the path under test, and by what it must match
+    std::function<void(const FractalView&, std::vector<int>&)> render;
+    std::function<void(const FractalView&, std::vector<int>&)> reference;
+};
+
+struct PixelDiff {
+    int x, y, expected, actual;
+};
+
+struct ViewDiff {
+    size_t differing = 0;
+    int maxDelta = 0;
+    std::vector<PixelDiff> samples;
+};
+
+ViewDiff compareIterations(const FractalView& view, const std::vector<int>& expected, const std::vector<int>& actual, size_t keep) {
+    ViewDiff diff;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i] == actual[i]) continue;
+        ++diff.differing;
+        diff.maxDelta = std::max(diff.maxDelta, std::abs(expected[i] - actual[i]));
+        if (diff.samples.size() < keep) {
+            diff.samples.push_back({static_cast<int>(i % view.width), static_cast<int>(i / view.width), expected[i], actual[i]});
+        }
+    }
+    return diff;
+}
+
+// White where the buffers differ
+bool writeDiffMask(const std::string& path, const FractalView& view, const std::vector<int>& expected, const std::vector<int>& actual) {
+    std::ofstream out(path, std::ios::binary);
+    out << "P5\n" << view.width << " " << view.height << "\n255\n";
+    for (size_t i = 0; i < expected.size(); ++i) out.put(expected[i] == actual[i] ? 0 : static_cast<char>(255));
+    return static_cast<bool>(out);
+}
+
+FractalView randomView(std::mt19937& random) {
+    auto uniform = [&](double lo, double hi) { return std::uniform_real_distribution<double>(lo, hi)(random); };
+    FractalView view;
+    view.formulaIndex = std::uniform_int_distribution<int>(0, formulaCount - 1)(random);
+    view.juliaMode = uniform(0, 1) < 0.3;
+    view.juliaC = std::complex<double>(uniform(-1, 1), uniform(-1, 1));
+    view.width = std::uniform_int_distribution<int>(48, 160)(random);
+    view.height = std::uniform_int_distribution<int>(32, 120)(random);
+    view.center = std::complex<double>(uniform(-1.5, 1.0), uniform(-1.2, 1.2));
+    view.zoom = view.width / 4.0 * std::pow(10.0, uniform(0, 4));
+    view.maxIter = std::uniform_int_distribution<int>(32, 512)(random);
+    return view;
+}
+
+std::string describeView(const FractalView& view) {
+    std::ostringstream text;
+    text << "--formula " << view.formulaIndex + 1 << " --size " << view.width << "x" << view.height << " --max-iter " << view.maxIter
+         << " --center " << view.center.real() << "," << view.center.imag() << " --zoom " << view.zoom;
+    if (view.juliaMode) text << " --julia " << view.juliaC.real() << "," << view.juliaC.imag();
+    return text.str();
+}
+
+int main(int argc, char** argv) {
+    CommandLine args(argc, argv, 1);
+    int views = std::max(args.getInt("views", 200), 1);
+    unsigned seed = static_cast<unsigned>(args.getInt("seed", 1));
+    size_t show = static_cast<size_t>(std::max(args.getInt("show", 10), 0));
+    std::string only = args.get("mode", "");
+    std::string diffDir = args.get("diff-dir", "");
+    TaskPool pool(renderThreadCount() - 1);
+
+    auto renderWith = [&](Kernel kernel, Precision precision) {
+        return [&pool, kernel, precision](const FractalView& view, std::vector<int>& out) {
+            FractalView v = view;
+            v.precision = precision;
+            out.assign(static_cast<size_t>(v.width) * v.height, 0);
+            renderInto(v, kernel, out.data(), v.width, &pool);
+        };
+    };
+    // Tiles of a random size, in a random order, over a random number of threads
+    std::mt19937 tileRandom(seed);
+    auto renderTiled = [&](const FractalView& view, std::vector<int>& out) {
+        std::vector<Tile> tiles = makeTiles(view.width, view.height, std::uniform_int_distribution<int>(8, 64)(tileRandom));
+        std::vector<int> order(tiles.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        std::shuffle(order.begin(), order.end(), tileRandom);
+        std::vector<uint64_t> costs;
+        renderTiles(view, out, tiles, order, std::uniform_int_distribution<int>(1, 8)(tileRandom), costs);
+    };
+    // Jittered supersampling the same way: the reference is one tile on one thread
+    const Sampling sampling = {4, static_cast<uint64_t>(seed)};
+    auto renderSampledTiled = [&](const FractalView& view, std::vector<int>& out) {
+        std::vector<Tile> tiles = makeTiles(view.width, view.height, std::uniform_int_distribution<int>(8, 64)(tileRandom));
+        std::vector<int> order(tiles.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        std::shuffle(order.begin(), order.end(), tileRandom);
+        std::vector<uint64_t> costs;
+        renderTiles(view, out, tiles, order, std::uniform_int_distribution<int>(1, 8)(tileRandom), costs, sampling);
+    };
+    auto renderSampledWhole = [&](const FractalView& view, std::vector<int>& out) {
+        std::vector<uint64_t> costs;
+        renderTiles(view, out, {Tile{0, 0, view.width, view.height}}, {0}, 1, costs, sampling);
+    };
+    // The explorer's path: random tiles on the pool, timed
+    auto renderPoolTiles = [&](const FractalView& view, std::vector<int>& out) {
+        std::vector<Tile> tiles = makeTiles(view.width, view.height, std::uniform_int_distribution<int>(8, 64)(tileRandom));
+        std::vector<TileCost> costs;
+        out.assign(static_cast<size_t>(view.width) * view.height, 0);
+        renderTilesInto(view, tiles, out.data(), view.width, pool, costs);
+    };
+    auto renderThreads = [](const FractalView& view, std::vector<int>& out) {
+        out.assign(static_cast<size_t>(view.width) * view.height, 0);
+        renderInto(view, Kernel::Scalar, out.data(), view.width);
+    };
+
+    // |z|^2 > 4 against |z| > 2 may escape one step apart right on the circle.
+    // Float against double drifts apart wherever orbits are chaotic, by any
+    // amount, so that mode only reports how much.
+    const DiffRule escapeTest = {1e-3, 1};
+    const DiffRule reportOnly = {1.0, INT_MAX};
+    std::vector<CheckMode> modes = {
+        {"scalar-double", "compile-time formula, norm escape test", escapeTest,
+         renderWith(Kernel::Scalar, Precision::Double), renderWith(Kernel::Reference, Precision::Double)},
+        {"scalar-float", "compile-time formula in float", escapeTest,
+         renderWith(Kernel::Scalar, Precision::Float), renderWith(Kernel::Reference, Precision::Float)},
+        {"float", "float against double precision, reported only", reportOnly,
+         renderWith(Kernel::Scalar, Precision::Float), renderWith(Kernel::Reference, Precision::Double)},
+        {"tiles", "random tiles, order and thread count", exact, renderTiled, renderWith(Kernel::Scalar, Precision::Double)},
+        {"threads", "temporary threads instead of the pool", exact, renderThreads, renderWith(Kernel::Scalar, Precision::Double)},
+        {"pool-tiles", "random tiles on the pool, as the explorer renders", exact, renderPoolTiles, renderWith(Kernel::Scalar, Precision::Double)},
+        {"supersample", "4 jittered samples, random tiles, order and thread count", exact, renderSampledTiled, renderSampledWhole},
+    };
+
+    std::mt19937 viewRandom(seed);
+    std::vector<FractalView> viewList;
+    for (int i = 0; i < views; ++i) viewList.push_back(randomView(viewRandom));
+
+    int failedModes = 0, checkedModes = 0;
+    std::vector<int> expected, actual;
+    for (const CheckMode& mode : modes) {
+        if (!only.empty() && only != mode.name) continue;
+        ++checkedModes;
+        auto start = std::chrono::steady_clock::now();
+        int failed = 0, differingViews = 0;
+        size_t pixels = 0, differing = 0;
+        int maxDelta = 0;
+        for (int v = 0; v < views; ++v) {
+            const FractalView& view = viewList[v];
+            mode.reference(view, expected);
+            mode.render(view, actual);
+            ViewDiff diff = compareIterations(view, expected, actual, show);
+            pixels += expected.size();
+            differing += diff.differing;
+            maxDelta = std::max(maxDelta, diff.maxDelta);
+            if (diff.differing == 0) continue;
+            ++differingViews;
+            bool pass = diff.differing <= mode.rule.maxFraction * expected.size() && diff.maxDelta <= mode.rule.maxDelta;
+            if (pass) continue;
+            ++failed;
+            std::cout << mode.name << " FAIL view " << v << ": " << diff.differing << " of " << expected.size()
+                      << " pixels differ, max delta " << diff.maxDelta << "\n  " << describeView(view) << std::endl;
+            for (const PixelDiff& pixel : diff.samples) {
+                std::cout << "  (" << pixel.x << ", " << pixel.y << ") expected " << pixel.expected << " got " << pixel.actual << std::endl;
+            }
+            if (!diffDir.empty()) {
+                std::string path = diffDir + "/" + mode.name + "_" + std::to_string(v) + ".pgm";
+                if (!writeDiffMask(path, view, expected, actual)) std::cerr << "Failed to write " << path << std::endl;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << (failed ? "FAIL " : "ok   ") << mode.name << " (" << mode.description << "): " << views << " views, "
+                  << differingViews << " with diffs, " << failed << " failed; " << differing << " of " << pixels
+                  << " pixels differ, max delta " << maxDelta << " [" << seconds << "s]" << std::endl;
+        failedModes += failed > 0;
+    }
+    if (checkedModes == 0) {
+        std::cerr << "No check mode named " << only << std::endl;
+        return 1;
+    }
+    return failedModes > 0 ? 1 : 0;
+}
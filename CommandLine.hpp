@@ -0,0 +1,73 @@
+#pragma once
+
+#include "FractalCore.hpp"
+
+#include <map>
+#include <string>
+#include <algorithm>
+
+// Minimal "--key value" reader for the headless commands
+struct CommandLine {
+    std::map<std::string, std::string> options;
+
+    CommandLine(int argc, char** argv, int first) {
+        for (int i = first; i < argc; ++i) {
+            std::string key = argv[i];
+            if (key.compare(0, 2, "--") != 0) continue;
+            key = key.substr(2);
+            if (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0) {
+                options[key] = argv[++i];
+            } else {
+                options[key] = "1";
+            }
+        }
+    }
+
+    bool has(const std::string& key) const { return options.count(key) > 0; }
+
+    std::string get(const std::string& key, const std::string& fallback) const {
+        auto it = options.find(key);
+        return it != options.end() ? it->second : fallback;
+    }
+    double getDouble(const std::string& key, double fallback) const {
+        return has(key) ? std::stod(get(key, "")) : fallback;
+    }
+    int getInt(const std::string& key, int fallback) const {
+        return has(key) ? std::stoi(get(key, "")) : fallback;
+    }
+    // "re,im"
+    std::complex<double> getComplex(const std::string& key, std::complex<double> fallback) const {
+        if (!has(key)) return fallback;
+        std::string value = get(key, "");
+        size_t comma = value.find(',');
+        if (comma == std::string::npos) return std::complex<double>(std::stod(value), 0.0);
+        return std::complex<double>(std::stod(value.substr(0, comma)), std::stod(value.substr(comma + 1)));
+    }
+};
+
+// Shared view options: --formula 1-4 --julia re,im --size WxH --max-iter N --center re,im --zoom Z --precision float|double
+inline FractalView viewFromCommandLine(const CommandLine& args) {
+    FractalView view;
+    view.formulaIndex = std::min(std::max(args.getInt("formula", 1), 1), 4) - 1;
+    view.juliaMode = args.has("julia");
+    view.juliaC = args.getComplex("julia", view.juliaC);
+    std::string size = args.get("size", "800x600");
+    size_t x = size.find('x');
+    if (x != std::string::npos) {
+        view.width = std::stoi(size.substr(0, x));
+        view.height = std::stoi(size.substr(x + 1));
+    }
+    view.maxIter = args.getInt("max-iter", view.maxIter);
+    view.center = args.getComplex("center", view.center);
+    view.zoom = args.getDouble("zoom", view.zoom);
+    view.precision = args.get("precision", "double") == "float" ? Precision::Float : Precision::Double;
+    return view;
+}
+
+// --samples N (jittered, per pixel) --seed S
+inline Sampling samplingFromCommandLine(const CommandLine& args) {
+    Sampling sampling;
+    sampling.samples = std::max(args.getInt("samples", 1), 1);
+    sampling.seed = std::stoull(args.get("seed", "0"));
+    return sampling;
+}
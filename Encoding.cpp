@@ -0,0 +1,268 @@
+#include "Encoding.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <zlib.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// --- Parallel PNG encoder ---
+//
+// Rows are split into strips that are filtered and deflated independently on
+// all cores. Every strip but the last ends on a Z_FULL_FLUSH boundary, so the
+// raw deflate streams concatenate into one valid zlib stream; the Adler-32
+// checksums are merged with adler32_combine.
+
+inline int paethPredictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// PNG filter 'type' applied to one row (prev is all zero above the first row)
+void filterRow(int type, const uint8_t* row, const uint8_t* prev, size_t length, int bpp, uint8_t* out) {
+    for (size_t i = 0; i < length; ++i) {
+        int left = i >= static_cast<size_t>(bpp) ? row[i - bpp] : 0;
+        int up = prev[i];
+        int upLeft = i >= static_cast<size_t>(bpp) ? prev[i - bpp] : 0;
+        int predicted = 0;
+        switch (type) {
+        case 1: predicted = left; break;
+        case 2: predicted = up; break;
+        case 3: predicted = (left + up) >> 1; break;
+        case 4: predicted = paethPredictor(left, up, upLeft); break;
+        default: break;
+        }
+        out[i] = static_cast<uint8_t>(row[i] - predicted);
+    }
+}
+
+// Minimum sum of absolute (signed) differences heuristic from the PNG spec
+uint64_t filterScore(const uint8_t* data, size_t length) {
+    uint64_t score = 0;
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sums = zero;
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // |signed byte| == min(b, 256 - b) on the unsigned bytes
+        __m128i magnitude = _mm_min_epu8(v, _mm_sub_epi8(zero, v));
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(magnitude, zero));
+    }
+    score = static_cast<uint64_t>(_mm_cvtsi128_si32(sums)) + static_cast<uint64_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+#endif
+    for (; i < length; ++i) score += std::min<int>(data[i], 256 - data[i]);
+    return score;
+}
+
+struct PngStrip {
+    std::vector<uint8_t> deflated;
+    uLong adler = 1;
+    size_t filteredLength = 0;
+};
+
+// Filter rows [rowBegin, rowEnd) of opaque RGBA as RGB and deflate them
+void deflatePngStrip(const uint8_t* rgba, int width, int rowBegin, int rowEnd, bool last, int level, PngStrip& strip) {
+    size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> previous(stride, 0), current(stride), candidate(stride), best(stride);
+    std::vector<uint8_t> filtered;
+    filtered.reserve((stride + 1) * (rowEnd - rowBegin));
+    auto toRgb = [&](int row, std::vector<uint8_t>& out) {
+        const uint8_t* in = rgba + static_cast<size_t>(row) * width * 4;
+        for (int x = 0; x < width; ++x) {
+            out[3 * x] = in[4 * x]; out[3 * x + 1] = in[4 * x + 1]; out[3 * x + 2] = in[4 * x + 2];
+        }
+    };
+    if (rowBegin > 0) toRgb(rowBegin - 1, previous);
+    for (int row = rowBegin; row < rowEnd; ++row) {
+        toRgb(row, current);
+        int bestType = 0;
+        uint64_t bestScore = UINT64_MAX;
+        for (int type = 0; type < 5; ++type) {
+            filterRow(type, current.data(), previous.data(), stride, 3, candidate.data());
+            uint64_t score = filterScore(candidate.data(), stride);
+            if (score < bestScore) {
+                bestScore = score;
+                bestType = type;
+                best.swap(candidate);
+            }
+        }
+        filtered.push_back(static_cast<uint8_t>(bestType));
+        filtered.insert(filtered.end(), best.begin(), best.end());
+        previous.swap(current);
+    }
+
+    strip.filteredLength = filtered.size();
+    strip.adler = adler32(adler32(0L, Z_NULL, 0), filtered.data(), static_cast<uInt>(filtered.size()));
+    z_stream stream = {};
+    deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY); // raw deflate, no per-strip header
+    strip.deflated.resize(deflateBound(&stream, static_cast<uLong>(filtered.size())) + 16);
+    stream.next_in = filtered.data();
+    stream.avail_in = static_cast<uInt>(filtered.size());
+    stream.next_out = strip.deflated.data();
+    stream.avail_out = static_cast<uInt>(strip.deflated.size());
+    deflate(&stream, last ? Z_FINISH : Z_FULL_FLUSH);
+    strip.deflated.resize(stream.total_out);
+    deflateEnd(&stream);
+}
+
+void appendPngChunk(std::vector<uint8_t>& png, const char* type, const uint8_t* data, size_t length) {
+    uint8_t header[8] = {
+        static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16), static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length),
+        static_cast<uint8_t>(type[0]), static_cast<uint8_t>(type[1]), static_cast<uint8_t>(type[2]), static_cast<uint8_t>(type[3])};
+    png.insert(png.end(), header, header + 8);
+    uLong crc = crc32(crc32(0L, Z_NULL, 0), header + 4, 4);
+    if (length > 0) {
+        png.insert(png.end(), data, data + length);
+        crc = crc32(crc, data, static_cast<uInt>(length));
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) png.push_back(static_cast<uint8_t>(crc >> shift));
+}
+
+void encodePng(const uint8_t* rgba, int width, int height, std::vector<uint8_t>& png, int threads,
+               const PngText& text, int level) {
+    // Strips of roughly 256 KiB of pixel data, at least one per worker
+    int workers = threads > 0 ? threads : renderThreadCount();
+    int rowsPerStrip = std::max(1, std::min(262144 / std::max(width * 3, 1), (height + workers - 1) / workers));
+    int stripCount = (height + rowsPerStrip - 1) / rowsPerStrip;
+    std::vector<PngStrip> strips(stripCount);
+    parallelRows(stripCount, [&](int s) {
+        deflatePngStrip(rgba, width, s * rowsPerStrip, std::min((s + 1) * rowsPerStrip, height), s == stripCount - 1, level, strips[s]);
+    }, workers);
+
+    static const uint8_t signature[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    png.assign(signature, signature + 8);
+    uint8_t header[13] = {
+        static_cast<uint8_t>(width >> 24), static_cast<uint8_t>(width >> 16), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+        static_cast<uint8_t>(height >> 24), static_cast<uint8_t>(height >> 16), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+        8, 2, 0, 0, 0}; // 8-bit RGB, deflate, adaptive filtering, no interlace
+    appendPngChunk(png, "IHDR", header, sizeof(header));
+    for (const auto& entry : text) {
+        std::string payload = entry.first + '\0' + entry.second;
+        appendPngChunk(png, "tEXt", reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+    }
+
+    // One IDAT per strip: zlib header on the first, Adler-32 trailer on the last
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for (int s = 0; s < stripCount; ++s) {
+        adler = adler32_combine(adler, strips[s].adler, static_cast<z_off_t>(strips[s].filteredLength));
+        std::vector<uint8_t>& data = strips[s].deflated;
+        if (s == 0) data.insert(data.begin(), {0x78, 0x9C});
+        if (s == stripCount - 1) {
+            for (int shift = 24; shift >= 0; shift -= 8) data.push_back(static_cast<uint8_t>(adler >> shift));
+        }
+        appendPngChunk(png, "IDAT", data.data(), data.size());
+    }
+    appendPngChunk(png, "IEND", nullptr, 0);
+}
+
+bool writePngFile(const std::string& path, const uint8_t* rgba, int width, int height, int threads, const PngText& text) {
+    std::vector<uint8_t> png;
+    encodePng(rgba, width, height, png, threads, text);
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(png.data()), png.size());
+    return static_cast<bool>(out);
+}
+
+// --- Raw frame conversion ---
+
+void rgbaToYuv420(const uint8_t* rgba, int width, int height, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane) {
+    int chromaWidth = (width + 1) / 2;
+    for (int row = 0; row < height; row += 2) {
+        const uint8_t* top = rgba + static_cast<size_t>(row) * width * 4;
+        const uint8_t* bottom = row + 1 < height ? top + static_cast<size_t>(width) * 4 : top;
+        uint8_t* yTop = yPlane + static_cast<size_t>(row) * width;
+        uint8_t* yBottom = row + 1 < height ? yTop + width : yTop;
+        uint8_t* u = uPlane + static_cast<size_t>(row / 2) * chromaWidth;
+        uint8_t* v = vPlane + static_cast<size_t>(row / 2) * chromaWidth;
+        int x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        // 16 pixels of each row per step: 16 luma samples per row, 8 chroma samples
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        const __m128i ones = _mm_set1_epi16(1);
+        auto channels = [&](const uint8_t* p, __m128i& r, __m128i& g, __m128i& b) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+            r = _mm_packs_epi32(_mm_and_si128(lo, byteMask), _mm_and_si128(hi, byteMask));
+            g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), byteMask), _mm_and_si128(_mm_srli_epi32(hi, 8), byteMask));
+            b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), byteMask), _mm_and_si128(_mm_srli_epi32(hi, 16), byteMask));
+        };
+        auto luma = [&](__m128i r, __m128i g, __m128i b) {
+            // (66r + 129g + 25b + 128) >> 8 stays below 2^16, so unsigned 16-bit lanes suffice
+            __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+                                        _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(128)));
+            return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+        };
+        // Sum of each horizontal pixel pair from both rows, 8 lanes
+        auto blockSum = [&](__m128i t0, __m128i t1, __m128i b0, __m128i b1) {
+            __m128i first = _mm_add_epi32(_mm_madd_epi16(t0, ones), _mm_madd_epi16(b0, ones));
+            __m128i second = _mm_add_epi32(_mm_madd_epi16(t1, ones), _mm_madd_epi16(b1, ones));
+            return _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(first, second), _mm_set1_epi16(2)), 2);
+        };
+        for (; x + 16 <= width; x += 16) {
+            __m128i tr0, tg0, tb0, tr1, tg1, tb1, br0, bg0, bb0, br1, bg1, bb1;
+            channels(top + x * 4, tr0, tg0, tb0);
+            channels(top + x * 4 + 32, tr1, tg1, tb1);
+            channels(bottom + x * 4, br0, bg0, bb0);
+            channels(bottom + x * 4 + 32, br1, bg1, bb1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(yTop + x), _mm_packus_epi16(luma(tr0, tg0, tb0), luma(tr1, tg1, tb1)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(yBottom + x), _mm_packus_epi16(luma(br0, bg0, bb0), luma(br1, bg1, bb1)));
+
+            __m128i r = blockSum(tr0, tr1, br0, br1);
+            __m128i g = blockSum(tg0, tg1, bg0, bg1);
+            __m128i b = blockSum(tb0, tb1, bb0, bb1);
+            __m128i cb = _mm_add_epi16(_mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(112)),
+                _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(38)), _mm_mullo_epi16(g, _mm_set1_epi16(74)))), _mm_set1_epi16(128)), 8), _mm_set1_epi16(128));
+            __m128i cr = _mm_add_epi16(_mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(112)),
+                _mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(94)), _mm_mullo_epi16(b, _mm_set1_epi16(18)))), _mm_set1_epi16(128)), 8), _mm_set1_epi16(128));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2), _mm_packus_epi16(cb, cb));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2), _mm_packus_epi16(cr, cr));
+        }
+#endif
+        for (; x < width; x += 2) {
+            int x1 = std::min(x + 1, width - 1);
+            const uint8_t* p[4] = {top + x * 4, top + x1 * 4, bottom + x * 4, bottom + x1 * 4};
+            int r = 0, g = 0, b = 0;
+            for (int k = 0; k < 4; ++k) {
+                r += p[k][0]; g += p[k][1]; b += p[k][2];
+            }
+            for (int k = 0; k < 4; ++k) {
+                uint8_t* out = (k < 2 ? yTop : yBottom) + (k % 2 ? x1 : x);
+                *out = static_cast<uint8_t>(((66 * p[k][0] + 129 * p[k][1] + 25 * p[k][2] + 128) >> 8) + 16);
+            }
+            r = (r + 2) >> 2; g = (g + 2) >> 2; b = (b + 2) >> 2;
+            u[x / 2] = clampLevel(((112 * b - 38 * r - 74 * g + 128) >> 8) + 128);
+            v[x / 2] = clampLevel(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+PngText viewTextChunks(const FractalView& view, const Sampling& sampling) {
+    std::ostringstream command;
+    command.precision(17);
+    command << "render --formula " << (view.formulaIndex + 1) << " --center " << view.center.real() << "," << view.center.imag()
+            << " --zoom " << view.zoom << " --size " << view.width << "x" << view.height << " --max-iter " << view.maxIter;
+    if (view.juliaMode) command << " --julia " << view.juliaC.real() << "," << view.juliaC.imag();
+    if (view.precision == Precision::Float) command << " --precision float";
+    if (sampling.samples > 1) command << " --samples " << sampling.samples << " --seed " << sampling.seed;
+    PngText text;
+    text.emplace_back("Software", "Celtic Orbit Explorer");
+    text.emplace_back("Formula", std::to_string(view.formulaIndex + 1));
+    text.emplace_back("Command", command.str());
+    return text;
+}
+
+void writeTileCostsHeader(std::ostream& out) {
+    out << "frame,formula,julia,x0,y0,x1,y1,iterations,microseconds\n";
+}
+
+void writeTileCostsCsv(std::ostream& out, int frame, const FractalView& view, const std::vector<TileCost>& costs) {
+    for (const TileCost& cost : costs) {
+        out << frame << "," << view.formulaIndex + 1 << "," << view.juliaMode << "," << cost.tile.x0 << "," << cost.tile.y0 << ","
+            << cost.tile.x1 << "," << cost.tile.y1 << "," << cost.iterations << "," << static_cast<int64_t>(cost.seconds * 1e6) << "\n";
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Image and video frame encoding for the exporters (needs zlib, not SFML)
+
+#include "FractalCore.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::vector<std::pair<std::string, std::string>> PngText;
+
+// Opaque RGBA to an RGB PNG, deflated on 'threads' workers (0 = all cores)
+void encodePng(const uint8_t* rgba, int width, int height, std::vector<uint8_t>& png, int threads = 0,
+               const PngText& text = PngText(), int level = 6);
+
+bool writePngFile(const std::string& path, const uint8_t* rgba, int width, int height, int threads = 0, const PngText& text = PngText());
+
+// Text chunks that describe the view, including a render command that reproduces it
+PngText viewTextChunks(const FractalView& view, const Sampling& sampling = Sampling());
+
+// RGBA to limited-range BT.601 Y'CbCr 4:2:0 planes; chroma is the 2x2 block average
+void rgbaToYuv420(const uint8_t* rgba, int width, int height, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane);
+
+// Per-tile cost as CSV: a header line, then one row per tile of each rendered frame
+// (frame,formula,julia,x0,y0,x1,y1,iterations,microseconds)
+void writeTileCostsHeader(std::ostream& out);
+void writeTileCostsCsv(std::ostream& out, int frame, const FractalView& view, const std::vector<TileCost>& costs);
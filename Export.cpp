@@ -0,0 +1,819 @@
+#include "Export.hpp"
+#include "Encoding.hpp"
+#include "SharedFrameRing.hpp"
+#include "Trace.hpp"
+
+#include <SFML/System.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+// --- Export pipeline ---
+//
+// Kernel workers -> colour workers -> encoder workers, joined by bounded
+// lock-free queues. A full queue stalls the stage feeding it, so the number of
+// frames in flight stays capped and throughput settles at the slowest stage.
+
+struct PipelineFrame {
+    int index = 0;
+    FractalView view;
+    int iterationScale = 1; // fixed-point scale when iterations were resampled
+    uint64_t iterationCost = 0;
+    std::vector<int> iterations;
+    std::vector<sf::Uint8> rgba;
+    std::vector<sf::Uint8> encoded; // encoder output, e.g. YUV planes
+};
+
+// Encoder stage, plus an optional writer that must see frames in index order
+struct FrameSink {
+    std::function<void(PipelineFrame&)> encode;
+    std::function<void(PipelineFrame&)> writeInOrder;
+};
+
+struct PipelineStages {
+    int kernelThreads = 1;
+    int colourThreads = 1;
+    int encoderThreads = 1;
+    int queueDepth = 4;
+};
+
+// --kernel-threads N --colour-threads N --encoder-threads N --queue-depth N
+PipelineStages stagesFromCommandLine(const CommandLine& args, int kernelThreads) {
+    PipelineStages stages;
+    int cores = renderThreadCount();
+    stages.kernelThreads = std::max(args.getInt("kernel-threads", kernelThreads), 1);
+    stages.colourThreads = std::max(args.getInt("colour-threads", std::max(cores / 8, 1)), 1);
+    stages.encoderThreads = std::max(args.getInt("encoder-threads", std::max(cores / 2, 1)), 1);
+    stages.queueDepth = std::max(args.getInt("queue-depth", 4), 1);
+    return stages;
+}
+
+struct PipelineStats {
+    int frames = 0;
+    float wallSeconds = 0;
+    float kernelSeconds = 0; // busy time summed over the stage's threads
+    float colourSeconds = 0;
+    float encodeSeconds = 0;
+    uint64_t iterations = 0;
+};
+
+// Push frames [0, frameCount) through render -> colour -> encode
+PipelineStats runFramePipeline(int frameCount, const PipelineStages& stages, const Palette& palette,
+                               const std::function<void(PipelineFrame&)>& render, const FrameSink& sink) {
+    typedef std::unique_ptr<PipelineFrame> FramePtr;
+    // Recycled frames; the pool size is what bounds memory and frames in flight
+    int poolSize = stages.kernelThreads + stages.colourThreads + stages.encoderThreads + 2 * stages.queueDepth;
+    BoundedQueue<FramePtr> freeFrames(poolSize);
+    BoundedQueue<FramePtr> colourQueue(stages.queueDepth);
+    BoundedQueue<FramePtr> encodeQueue(stages.queueDepth);
+    for (int i = 0; i < poolSize; ++i) freeFrames.push(FramePtr(new PipelineFrame()));
+
+    std::atomic<int> nextFrame(0);
+    std::atomic<int> kernelsLeft(stages.kernelThreads), coloursLeft(stages.colourThreads);
+    std::atomic<int64_t> kernelMicros(0), colourMicros(0), encodeMicros(0);
+    std::atomic<uint64_t> iterations(0);
+
+    // Ordered writes: frames park in slot index % poolSize until their turn. A
+    // kernel thread claims the next frame index only once it holds a pool frame,
+    // so in-flight indices never collide on a slot, and the oldest unwritten
+    // index always has a frame and cannot wait behind the parked ones.
+    std::mutex writeMutex;
+    std::vector<FramePtr> parked(poolSize);
+    int nextToWrite = 0;
+
+    sf::Clock wall;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < stages.kernelThreads; ++t) {
+        workers.emplace_back([&]() {
+            Trace::nameThread("kernel stage");
+            FramePtr frame;
+            for (;;) {
+                freeFrames.pop(frame);
+                int f = nextFrame++;
+                if (f >= frameCount) {
+                    freeFrames.push(std::move(frame));
+                    break;
+                }
+                TRACE_ZONE("kernel frame");
+                frame->index = f;
+                frame->iterationScale = 1;
+                frame->iterationCost = 0;
+                sf::Clock busy;
+                render(*frame);
+                kernelMicros += busy.getElapsedTime().asMicroseconds();
+                iterations += frame->iterationCost;
+                colourQueue.push(std::move(frame));
+            }
+            if (--kernelsLeft == 0) colourQueue.close();
+        });
+    }
+    for (int t = 0; t < stages.colourThreads; ++t) {
+        workers.emplace_back([&]() {
+            FramePtr frame;
+            Trace::nameThread("colour stage");
+            while (colourQueue.pop(frame)) {
+                TRACE_ZONE("colour frame");
+                sf::Clock busy;
+                frame->rgba.resize(frame->iterations.size() * 4);
+                colourize(frame->iterations.data(), frame->iterations.size(), frame->view.maxIter,
+                          frame->iterationScale, palette, frame->rgba.data());
+                colourMicros += busy.getElapsedTime().asMicroseconds();
+                encodeQueue.push(std::move(frame));
+            }
+            if (--coloursLeft == 0) encodeQueue.close();
+        });
+    }
+    for (int t = 0; t < stages.encoderThreads; ++t) {
+        workers.emplace_back([&]() {
+            FramePtr frame;
+            Trace::nameThread("encode stage");
+            while (encodeQueue.pop(frame)) {
+                TRACE_ZONE("encode frame");
+                sf::Clock busy;
+                sink.encode(*frame);
+                if (sink.writeInOrder) {
+                    std::lock_guard<std::mutex> lock(writeMutex);
+                    parked[frame->index % poolSize] = std::move(frame);
+                    for (FramePtr* ready = &parked[nextToWrite % poolSize]; *ready && (*ready)->index == nextToWrite;
+                         ready = &parked[nextToWrite % poolSize]) {
+                        sink.writeInOrder(**ready);
+                        freeFrames.push(std::move(*ready));
+                        ++nextToWrite;
+                    }
+                } else {
+                    freeFrames.push(std::move(frame));
+                }
+                encodeMicros += busy.getElapsedTime().asMicroseconds();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    PipelineStats stats;
+    stats.frames = frameCount;
+    stats.wallSeconds = wall.getElapsedTime().asSeconds();
+    stats.kernelSeconds = kernelMicros / 1e6f;
+    stats.colourSeconds = colourMicros / 1e6f;
+    stats.encodeSeconds = encodeMicros / 1e6f;
+    stats.iterations = iterations;
+    return stats;
+}
+
+void printPipelineStats(const PipelineStats& stats, const PipelineStages& stages, std::ostream& out) {
+    // Per-stage time if that stage ran alone on its threads; the largest is the bound
+    float kernel = stats.kernelSeconds / stages.kernelThreads;
+    float colour = stats.colourSeconds / stages.colourThreads;
+    float encode = stats.encodeSeconds / stages.encoderThreads;
+    const char* slowest = kernel >= colour && kernel >= encode ? "kernel" : (colour >= encode ? "colour" : "encode");
+    out << stats.frames << " frames in " << stats.wallSeconds << "s"
+              << " (kernel " << kernel << "s x" << stages.kernelThreads
+              << ", colour " << colour << "s x" << stages.colourThreads
+              << ", encode " << encode << "s x" << stages.encoderThreads
+              << ", bound by " << slowest << ")";
+    if (stats.iterations > 0) {
+        out << ", " << stats.iterations / 1e6 / std::max(stats.wallSeconds, 1e-6f) << " Miter/s";
+    }
+    out << std::endl;
+}
+
+// Encoder stage for image sequences: --format png|raw
+std::function<void(PipelineFrame&)> makeFileEncoder(const std::string& outDir, const std::string& format, int pngThreads) {
+    return [outDir, format, pngThreads](PipelineFrame& frame) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/frame_%05d.%s", frame.index, format == "raw" ? "rgba" : "png");
+        bool written = false;
+        if (format == "raw") {
+            std::ofstream out(outDir + name, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(frame.rgba.data()), frame.rgba.size());
+            written = static_cast<bool>(out);
+        } else {
+            written = writePngFile(outDir + name, frame.rgba.data(), frame.view.width, frame.view.height, pngThreads);
+        }
+        if (!written) std::cerr << "Failed to write " << outDir << name << std::endl;
+    };
+}
+
+// --- Raw frame streaming (Y4M / RGBA to stdout or a named pipe) ---
+
+// Frames written straight from the pipeline buffers to stdout ("-") or a file / named pipe
+class FrameStream {
+public:
+    FrameStream(const std::string& path, const std::string& format, int fps) : y4m(format != "rgba"), fps(fps) {
+        if (path == "-") {
+#ifdef _WIN32
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+            file = stdout;
+        } else {
+            file = std::fopen(path.c_str(), "wb");
+            if (!file) std::cerr << "Failed to open " << path << std::endl;
+        }
+    }
+    ~FrameStream() {
+        if (file && file != stdout) std::fclose(file);
+        else if (file) std::fflush(file);
+    }
+
+    // Encoder stage: only Y4M needs a conversion, raw RGBA goes out as is
+    void encode(PipelineFrame& frame) const {
+        if (!y4m) return;
+        int width = frame.view.width, height = frame.view.height;
+        size_t lumaSize = static_cast<size_t>(width) * height;
+        size_t chromaSize = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+        frame.encoded.resize(lumaSize + 2 * chromaSize);
+        sf::Uint8* planes = frame.encoded.data();
+        rgbaToYuv420(frame.rgba.data(), width, height, planes, planes + lumaSize, planes + lumaSize + chromaSize);
+    }
+
+    // Called in frame order
+    void write(const PipelineFrame& frame) {
+        if (!file || failed) return;
+        if (y4m && !headerWritten) {
+            std::fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XYSCSS=420JPEG\n", frame.view.width, frame.view.height, fps);
+            headerWritten = true;
+        }
+        bool ok = y4m ? std::fputs("FRAME\n", file) >= 0 && std::fwrite(frame.encoded.data(), 1, frame.encoded.size(), file) == frame.encoded.size()
+                      : std::fwrite(frame.rgba.data(), 1, frame.rgba.size(), file) == frame.rgba.size();
+        if (!ok) {
+            std::cerr << "Frame stream closed at frame " << frame.index << std::endl;
+            failed = true;
+        }
+    }
+
+private:
+    FILE* file = nullptr;
+    bool y4m;
+    int fps;
+    bool headerWritten = false;
+    bool failed = false;
+};
+
+// --stream y4m|rgba [--output -|PATH] [--fps N] streams frames; otherwise files go to --out.
+// --shm NAME [--shm-slots N] also publishes the iteration counts of every frame, in order.
+FrameSink makeFrameSink(const CommandLine& args, const PipelineStages& stages, std::unique_ptr<FrameStream>& stream) {
+    FrameSink sink;
+    if (args.has("stream")) {
+        stream.reset(new FrameStream(args.get("output", "-"), args.get("stream", "y4m"), args.getInt("fps", 30)));
+        FrameStream* out = stream.get();
+        sink.encode = [out](PipelineFrame& frame) { out->encode(frame); };
+        sink.writeInOrder = [out](PipelineFrame& frame) { out->write(frame); };
+    } else {
+        // Encoder workers share the cores between frames and PNG strips
+        sink.encode = makeFileEncoder(args.get("out", "."), args.get("format", "png"),
+                                      std::max(renderThreadCount() / stages.encoderThreads, 1));
+    }
+    if (args.has("shm")) {
+        FractalView view = viewFromCommandLine(args);
+        std::shared_ptr<SharedFrameRing> ring = SharedFrameRing::create(args.get("shm", "celticframes"), args.getInt("shm-slots", 4),
+                                                                        static_cast<size_t>(view.width) * view.height);
+        if (ring) {
+            std::function<void(PipelineFrame&)> write = sink.writeInOrder;
+            sink.writeInOrder = [ring, write](PipelineFrame& frame) {
+                ring->publish(frame.view, frame.iterations.data(), frame.iterationScale);
+                if (write) write(frame);
+            };
+        }
+    }
+    return sink;
+}
+
+// Progress goes to stderr when stdout carries the video
+std::ostream& logStream(const CommandLine& args) {
+    return args.has("stream") && args.get("output", "-") == "-" ? std::cerr : std::cout;
+}
+
+// --- Zoom video export (exponential map) ---
+//
+// A zoom towards a fixed centre only ever needs the plane sampled on a log-polar
+// grid around that centre: pixel radius r at zoom Z maps to log(r) - log(Z), so
+// every frame is a shifted window onto one strip of (angle, log radius) samples.
+// The strip is rendered once and each frame is resampled from it.
+
+struct LogPolarStrip {
+    int angles = 0;        // samples around the circle
+    int radii = 0;         // samples along log radius
+    double logMin = 0.0;   // log radius (complex units) of row 0
+    double logStep = 0.0;  // equal to the angular step so samples stay square
+    std::vector<float> iterations; // radii rows of angles samples
+};
+
+LogPolarStrip renderLogPolarStrip(const FractalView& view, double startZoom, double endZoom) {
+    LogPolarStrip strip;
+    double halfDiagonal = 0.5 * std::hypot(double(view.width), double(view.height));
+    strip.angles = static_cast<int>(std::ceil(2 * M_PI * halfDiagonal));
+    strip.logStep = 2 * M_PI / strip.angles;
+    // Outermost pixel of the first frame down to half a pixel of the last one
+    double logMax = std::log(halfDiagonal / std::min(startZoom, endZoom));
+    strip.logMin = std::log(0.5 / std::max(startZoom, endZoom));
+    strip.radii = static_cast<int>(std::ceil((logMax - strip.logMin) / strip.logStep)) + 2;
+    strip.iterations.resize(static_cast<size_t>(strip.angles) * strip.radii);
+
+    std::vector<std::complex<double>> directions(strip.angles);
+    for (int a = 0; a < strip.angles; ++a) {
+        directions[a] = std::polar(1.0, -M_PI + a * strip.logStep);
+    }
+    parallelRows(strip.radii, [&](int row) {
+        double radius = std::exp(strip.logMin + row * strip.logStep);
+        float* out = &strip.iterations[static_cast<size_t>(row) * strip.angles];
+        for (int a = 0; a < strip.angles; ++a) {
+            out[a] = static_cast<float>(iterateView(view, view.center + radius * directions[a]));
+        }
+    });
+    return strip;
+}
+
+// Per-pixel strip coordinates that do not depend on the frame's zoom
+struct LogPolarLookup {
+    std::vector<float> column;    // fractional angle index
+    std::vector<float> logRadius; // log of the pixel distance from the centre
+};
+
+LogPolarLookup buildLogPolarLookup(const LogPolarStrip& strip, int width, int height) {
+    LogPolarLookup lookup;
+    lookup.column.resize(static_cast<size_t>(width) * height);
+    lookup.logRadius.resize(lookup.column.size());
+    for (int py = 0; py < height; ++py) {
+        for (int px = 0; px < width; ++px) {
+            double dx = px - width / 2.0;
+            double dy = py - height / 2.0;
+            size_t i = static_cast<size_t>(py) * width + px;
+            lookup.column[i] = static_cast<float>((std::atan2(dy, dx) + M_PI) / strip.logStep);
+            lookup.logRadius[i] = static_cast<float>(std::log(std::max(std::hypot(dx, dy), 0.5)));
+        }
+    }
+    return lookup;
+}
+
+// Fixed-point scale of the resampled iteration counts
+const int logPolarIterationScale = 256;
+
+// Bilinear resample of one frame at the given zoom into scaled iteration counts
+void remapLogPolarFrame(const LogPolarStrip& strip, const LogPolarLookup& lookup, double zoom, std::vector<int>& iterations) {
+    double rowOffset = (-std::log(zoom) - strip.logMin) / strip.logStep;
+    double rowScale = 1.0 / strip.logStep;
+    iterations.resize(lookup.column.size());
+    for (size_t i = 0; i < iterations.size(); ++i) {
+        double row = std::min(std::max(rowOffset + lookup.logRadius[i] * rowScale, 0.0), strip.radii - 1.001);
+        int r0 = static_cast<int>(row);
+        float fr = static_cast<float>(row - r0);
+        float col = lookup.column[i];
+        int a0 = static_cast<int>(col);
+        float fa = col - a0;
+        a0 %= strip.angles;
+        int a1 = (a0 + 1) % strip.angles;
+        const float* lo = &strip.iterations[static_cast<size_t>(r0) * strip.angles];
+        const float* hi = lo + strip.angles;
+        float iter = (lo[a0] * (1 - fa) + lo[a1] * fa) * (1 - fr) + (hi[a0] * (1 - fa) + hi[a1] * fa) * fr;
+        iterations[i] = static_cast<int>(iter * logPolarIterationScale + 0.5f);
+    }
+}
+
+// zoom-video --out DIR --frames N --start-zoom Z0 --end-zoom Z1 [--palette P] [output options] [pipeline options] [view options]
+int runZoomVideo(const CommandLine& args) {
+    FractalView view = viewFromCommandLine(args);
+    std::ostream& log = logStream(args);
+    int frames = std::max(args.getInt("frames", 300), 1);
+    double startZoom = args.getDouble("start-zoom", view.zoom);
+    double endZoom = args.getDouble("end-zoom", startZoom * 1e4);
+
+    sf::Clock clock;
+    LogPolarStrip strip = renderLogPolarStrip(view, startZoom, endZoom);
+    log << "Rendered log-polar strip " << strip.angles << "x" << strip.radii
+              << " in " << clock.restart().asSeconds() << "s" << std::endl;
+
+    // Remapping is cheap, so the kernel stage gets a quarter of the cores
+    LogPolarLookup lookup = buildLogPolarLookup(strip, view.width, view.height);
+    std::unique_ptr<FrameStream> stream;
+    PipelineStages stages = stagesFromCommandLine(args, std::max(renderThreadCount() / 4, 1));
+    PipelineStats stats = runFramePipeline(frames, stages, makePalette(args.get("palette", "grey")),
+        [&](PipelineFrame& frame) {
+            double t = frames > 1 ? double(frame.index) / (frames - 1) : 0.0;
+            frame.view = view;
+            frame.view.zoom = startZoom * std::pow(endZoom / startZoom, t);
+            frame.iterationScale = logPolarIterationScale;
+            remapLogPolarFrame(strip, lookup, frame.view.zoom, frame.iterations);
+        },
+        makeFrameSink(args, stages, stream));
+    printPipelineStats(stats, stages, log);
+    return 0;
+}
+
+// --- Julia morph animation ---
+
+// Uniform Catmull-Rom through the keyframes, t in [0, 1] over the whole path
+std::complex<double> catmullRom(const std::vector<std::complex<double>>& keys, double t) {
+    if (keys.size() == 1) return keys[0];
+    int segments = static_cast<int>(keys.size()) - 1;
+    double s = std::min(std::max(t, 0.0), 1.0) * segments;
+    int i = std::min(static_cast<int>(s), segments - 1);
+    double u = s - i;
+    auto key = [&](int k) { return keys[std::min(std::max(k, 0), segments)]; };
+    std::complex<double> p0 = key(i - 1), p1 = key(i), p2 = key(i + 1), p3 = key(i + 2);
+    return 0.5 * ((2.0 * p1) + (p2 - p0) * u + (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * (u * u) +
+                  (3.0 * p1 - p0 - 3.0 * p2 + p3) * (u * u * u));
+}
+
+// One "re,im" (or "re im") per line
+std::vector<std::complex<double>> loadKeyframes(const std::string& path) {
+    std::vector<std::complex<double>> keys;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        double re, im;
+        if (fields >> re >> im) keys.emplace_back(re, im);
+    }
+    return keys;
+}
+
+// julia-morph --keyframes FILE --out DIR --frames N [--tile 64] [--palette P] [output options] [pipeline options] [view options]
+//
+// Consecutive frames are nearly identical, so the tile costs measured on the
+// latest finished frame order the tiles of the next one (most expensive first).
+// When there are more cores than tiles, several frames render at once.
+int runJuliaMorph(const CommandLine& args) {
+    FractalView view = viewFromCommandLine(args);
+    view.juliaMode = true;
+    std::vector<std::complex<double>> keys = loadKeyframes(args.get("keyframes", "keyframes.txt"));
+    if (keys.empty()) {
+        std::cerr << "No keyframes in " << args.get("keyframes", "keyframes.txt") << std::endl;
+        return 1;
+    }
+    int frames = std::max(args.getInt("frames", 300), 1);
+    std::vector<Tile> tiles = makeTiles(view.width, view.height, std::max(args.getInt("tile", 64), 8));
+
+    int threads = renderThreadCount();
+    int framesInFlight = std::min(std::max(threads / static_cast<int>(tiles.size()), 1), frames);
+    PipelineStages stages = stagesFromCommandLine(args, framesInFlight);
+    int threadsPerFrame = std::max(threads / stages.kernelThreads, 1);
+
+    std::mutex costMutex;
+    std::vector<uint64_t> latestCosts(tiles.size(), 0);
+    std::unique_ptr<FrameStream> stream;
+    PipelineStats stats = runFramePipeline(frames, stages, makePalette(args.get("palette", "grey")),
+        [&](PipelineFrame& frame) {
+            std::vector<int> order;
+            {
+                std::lock_guard<std::mutex> lock(costMutex);
+                order = tileOrderByCost(latestCosts);
+            }
+            frame.view = view;
+            frame.view.juliaC = catmullRom(keys, frames > 1 ? double(frame.index) / (frames - 1) : 0.0);
+            std::vector<uint64_t> costs;
+            renderTiles(frame.view, frame.iterations, tiles, order, threadsPerFrame, costs);
+            for (uint64_t cost : costs) frame.iterationCost += cost;
+            std::lock_guard<std::mutex> lock(costMutex);
+            latestCosts = costs;
+        },
+        makeFrameSink(args, stages, stream));
+    std::ostream& log = logStream(args);
+    log << threadsPerFrame << " render threads per frame: ";
+    printPipelineStats(stats, stages, log);
+    return 0;
+}
+
+// --- Single image export ---
+
+// render --out FILE.png [--tile 64] [--threads N] [--shuffle] [--samples N --seed S] [--palette P] [--tile-costs FILE.csv] [view options]
+//
+// The output and its content hash are the same for any tile size, thread
+// count or tile order (--shuffle renders the tiles in a random order).
+int runRender(const CommandLine& args) {
+    FractalView view = viewFromCommandLine(args);
+    Sampling sampling = samplingFromCommandLine(args);
+    std::string path = args.get("out", "render.png");
+    std::vector<Tile> tiles = makeTiles(view.width, view.height, std::max(args.getInt("tile", 64), 8));
+    std::vector<int> order(tiles.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+    if (args.has("shuffle")) std::shuffle(order.begin(), order.end(), std::mt19937(std::random_device()()));
+
+    sf::Clock clock;
+    std::vector<int> iterations;
+    std::vector<TileCost> costs;
+    renderTiles(view, iterations, tiles, order, std::max(args.getInt("threads", renderThreadCount()), 1), costs, sampling);
+    uint64_t totalIterations = 0;
+    for (const TileCost& cost : costs) totalIterations += cost.iterations;
+    float renderSeconds = clock.restart().asSeconds();
+    if (args.has("tile-costs")) {
+        std::string csvPath = args.get("tile-costs", "tiles.csv");
+        std::ofstream csv(csvPath);
+        writeTileCostsHeader(csv);
+        writeTileCostsCsv(csv, 0, view, costs);
+        if (!csv) std::cerr << "Failed to write " << csvPath << std::endl;
+    }
+
+    std::vector<sf::Uint8> rgba(iterations.size() * 4);
+    colourize(iterations.data(), iterations.size(), view.maxIter, sampling.iterationScale(), makePalette(args.get("palette", "grey")), rgba.data());
+    if (!writePngFile(path, rgba.data(), view.width, view.height)) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return 1;
+    }
+    std::cout << "Rendered " << view.width << "x" << view.height << " in " << renderSeconds << "s ("
+              << totalIterations / 1e6 / std::max(renderSeconds, 1e-6f) << " Miter/s), colour + PNG in "
+              << clock.getElapsedTime().asSeconds() << "s -> " << path << ", hash " << formatHash(hashIterations(iterations)) << std::endl;
+    return 0;
+}
+
+// --- Shared-memory frame reader ---
+
+// shm-read --shm NAME [--frames N] [--timeout 5] [--out FILE.png] [--palette P]
+//
+// Follows the newest frame of a ring published with --shm, reading it in place.
+// Frames the writer overwrote before we got to them are counted as skipped.
+int runSharedFrameReader(const CommandLine& args) {
+    std::unique_ptr<SharedFrameRing> ring = SharedFrameRing::open(args.get("shm", "celticframes"));
+    if (!ring) return 1;
+    int wanted = args.getInt("frames", 0); // 0: until the writer goes quiet
+    float timeout = static_cast<float>(args.getDouble("timeout", 5.0));
+    std::string path = args.get("out", "");
+    std::cout << "Reading " << ring->slots() << " slots of up to " << ring->maxPixels() << " pixels" << std::endl;
+
+    uint64_t next = ring->published();
+    int read = 0, skipped = 0, torn = 0;
+    SharedFrameInfo last;
+    std::vector<int> saved;
+    sf::Clock idle;
+    while ((wanted == 0 || read < wanted) && idle.getElapsedTime().asSeconds() < timeout) {
+        uint64_t published = ring->published();
+        if (published <= next) {
+            sf::sleep(sf::milliseconds(1));
+            continue;
+        }
+        idle.restart();
+        uint64_t number = published - 1;
+        SharedFrameInfo info;
+        uint64_t sum = 0;
+        bool complete = ring->read(number, [&](const SharedFrameInfo& frame, const int* iterations) {
+            info = frame;
+            size_t count = static_cast<size_t>(frame.width) * frame.height;
+            for (size_t i = 0; i < count; ++i) sum += static_cast<uint64_t>(std::max(iterations[i], 0));
+            if (!path.empty()) saved.assign(iterations, iterations + count);
+        });
+        if (!complete) {
+            ++torn;
+            continue;
+        }
+        skipped += static_cast<int>(number - next);
+        next = number + 1;
+        ++read;
+        last = info;
+        FractalView view = info.view();
+        std::cout << "frame " << info.frame << ": " << view.width << "x" << view.height << " formula " << view.formulaIndex + 1
+                  << (view.juliaMode ? " julia" : " mandelbrot") << " center " << view.center.real() << "," << view.center.imag()
+                  << " zoom " << view.zoom << " mean iterations "
+                  << double(sum) / info.iterationScale / std::max<size_t>(size_t(view.width) * view.height, 1) << std::endl;
+    }
+    std::cout << read << " frames read, " << skipped << " skipped, " << torn << " overwritten while reading" << std::endl;
+
+    if (!path.empty() && read > 0) {
+        FractalView view = last.view();
+        std::vector<sf::Uint8> rgba(saved.size() * 4);
+        colourize(saved.data(), saved.size(), view.maxIter, last.iterationScale, makePalette(args.get("palette", "grey")), rgba.data());
+        if (!writePngFile(path, rgba.data(), view.width, view.height, 0, viewTextChunks(view))) {
+            std::cerr << "Failed to write " << path << std::endl;
+            return 1;
+        }
+        std::cout << "Last frame -> " << path << std::endl;
+    }
+    return read > 0 ? 0 : 1;
+}
+
+// --- Batch jobs (JSON lines) ---
+
+// Value of a flat JSON object: strings/literals in text, numbers and number arrays in numbers
+struct JsonValue {
+    std::string text;
+    std::vector<double> numbers;
+};
+
+// One flat JSON object per line; nested objects are not supported
+bool parseJsonLine(const std::string& line, std::map<std::string, JsonValue>& object) {
+    size_t i = 0;
+    auto skip = [&] { while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i; };
+    auto parseString = [&](std::string& out) {
+        if (line[i] != '"') return false;
+        for (++i; i < line.size() && line[i] != '"'; ++i) {
+            if (line[i] == '\\' && i + 1 < line.size()) {
+                char escaped = line[++i];
+                out += escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped;
+            } else {
+                out += line[i];
+            }
+        }
+        return i++ < line.size();
+    };
+    auto parseNumber = [&](std::vector<double>& out) {
+        const char* start = line.c_str() + i;
+        char* end = nullptr;
+        double value = std::strtod(start, &end);
+        if (end == start) return false;
+        out.push_back(value);
+        i += end - start;
+        return true;
+    };
+
+    skip();
+    if (i >= line.size() || line[i++] != '{') return false;
+    for (;;) {
+        skip();
+        if (i < line.size() && line[i] == '}') return true;
+        std::string key;
+        if (i >= line.size() || !parseString(key)) return false;
+        skip();
+        if (i >= line.size() || line[i++] != ':') return false;
+        skip();
+        if (i >= line.size()) return false;
+        JsonValue& value = object[key];
+        if (line[i] == '"') {
+            if (!parseString(value.text)) return false;
+        } else if (line[i] == '[') {
+            for (++i, skip(); i < line.size() && line[i] != ']'; skip()) {
+                if (!parseNumber(value.numbers)) return false;
+                skip();
+                if (i < line.size() && line[i] == ',') ++i;
+            }
+            if (i++ >= line.size()) return false;
+        } else if (std::isalpha(static_cast<unsigned char>(line[i]))) {
+            while (i < line.size() && std::isalpha(static_cast<unsigned char>(line[i]))) value.text += line[i++];
+        } else if (!parseNumber(value.numbers)) {
+            return false;
+        }
+        skip();
+        if (i < line.size() && line[i] == ',') ++i;
+        else if (i < line.size() && line[i] == '}') return true;
+        else return false;
+    }
+}
+
+struct BatchJob {
+    FractalView view;
+    std::string output;
+    std::string palette;
+    int line = 0;
+    std::vector<int> iterations;
+    std::atomic<int> tilesLeft{0};
+    std::atomic<uint64_t> iterationCost{0};
+    std::atomic<bool> begun{false};
+    sf::Clock started; // restarted when the first tile is picked up
+    float seconds = 0;
+};
+
+// Keys: formula, mode ("julia"/"mandelbrot"), juliaC [re,im], centre [re,im],
+// scale (plane width shown) or zoom (pixels per unit), size [w,h], maxIter, output, palette
+bool batchJobFromJson(const std::map<std::string, JsonValue>& object, BatchJob& job) {
+    auto find = [&](const char* key) -> const JsonValue* {
+        auto it = object.find(key);
+        return it != object.end() ? &it->second : nullptr;
+    };
+    FractalView& view = job.view;
+    if (const JsonValue* size = find("size")) {
+        if (size->numbers.size() == 2) {
+            view.width = static_cast<int>(size->numbers[0]);
+            view.height = static_cast<int>(size->numbers[1]);
+        } else if (std::sscanf(size->text.c_str(), "%dx%d", &view.width, &view.height) != 2) {
+            return false;
+        }
+    }
+    if (const JsonValue* formula = find("formula")) {
+        int index = formula->numbers.empty() ? std::atoi(formula->text.c_str()) : static_cast<int>(formula->numbers[0]);
+        view.formulaIndex = std::min(std::max(index, 1), 4) - 1;
+    }
+    if (const JsonValue* juliaC = find("juliaC")) {
+        if (juliaC->numbers.size() != 2) return false;
+        view.juliaC = std::complex<double>(juliaC->numbers[0], juliaC->numbers[1]);
+    }
+    const JsonValue* mode = find("mode");
+    view.juliaMode = mode ? mode->text == "julia" : find("juliaC") != nullptr;
+    const JsonValue* centre = find("centre") ? find("centre") : find("center");
+    if (centre) {
+        if (centre->numbers.size() != 2) return false;
+        view.center = std::complex<double>(centre->numbers[0], centre->numbers[1]);
+    }
+    if (const JsonValue* scale = find("scale")) {
+        if (scale->numbers.empty() || scale->numbers[0] <= 0) return false;
+        view.zoom = view.width / scale->numbers[0];
+    } else if (const JsonValue* zoom = find("zoom")) {
+        if (zoom->numbers.empty()) return false;
+        view.zoom = zoom->numbers[0];
+    }
+    if (const JsonValue* maxIter = find("maxIter")) {
+        if (maxIter->numbers.empty()) return false;
+        view.maxIter = std::max(static_cast<int>(maxIter->numbers[0]), 1);
+    }
+    const JsonValue* output = find("output");
+    if (!output || output->text.empty()) return false;
+    job.output = output->text;
+    job.palette = find("palette") ? find("palette")->text : "grey";
+    return view.width > 0 && view.height > 0;
+}
+
+// batch --jobs FILE.jsonl [--threads N] [--tile 64] [--cache-tiles 65536] [--cache-dir DIR]
+//
+// All jobs share one worker pool and one cache of iteration tiles, so repeated
+// or overlapping views (same grid, e.g. a re-run with another palette) are not
+// rendered twice.
+int runBatch(const CommandLine& args) {
+    std::string path = args.get("jobs", "jobs.jsonl");
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+    std::vector<std::unique_ptr<BatchJob>> jobs;
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        std::map<std::string, JsonValue> object;
+        std::unique_ptr<BatchJob> job(new BatchJob());
+        job->line = number;
+        if (!parseJsonLine(line, object) || !batchJobFromJson(object, *job)) {
+            std::cerr << path << ":" << number << ": skipped, not a valid view description" << std::endl;
+            continue;
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    int tileSize = std::max(args.getInt("tile", 64), 8);
+    TileCache cache(static_cast<size_t>(args.getInt("cache-tiles", 65536)), args.get("cache-dir", ""));
+    std::mutex reportMutex;
+    std::atomic<int> failures(0);
+    sf::Clock clock;
+    {
+        TaskPool pool(std::max(args.getInt("threads", renderThreadCount()), 1));
+        for (auto& owned : jobs) {
+            BatchJob* job = owned.get();
+            const FractalView& view = job->view;
+            std::vector<Tile> tiles = makeTiles(view.width, view.height, tileSize);
+            job->iterations.resize(static_cast<size_t>(view.width) * view.height);
+            job->tilesLeft = static_cast<int>(tiles.size());
+            for (const Tile& tile : tiles) {
+                pool.submit([&, job, tile] {
+                    if (!job->begun.exchange(true)) job->started.restart();
+                    const FractalView& view = job->view;
+                    // Tiles match only on the same pixel grid: same plane coordinates of the tile corner and step
+                    std::complex<double> corner = pixelToComplex(view, tile.x0, tile.y0);
+                    std::ostringstream key;
+                    key.precision(17);
+                    key << view.formulaIndex << "_" << view.juliaMode << "_" << view.juliaC.real() << "_" << view.juliaC.imag() << "_"
+                        << view.maxIter << "_" << view.zoom << "_" << corner.real() << "_" << corner.imag() << "_"
+                        << (tile.x1 - tile.x0) << "x" << (tile.y1 - tile.y0);
+                    int tileWidth = tile.x1 - tile.x0;
+                    size_t tileBytes = static_cast<size_t>(tileWidth) * (tile.y1 - tile.y0) * sizeof(int);
+                    TileCache::Blob data = cache.get(key.str(), [&] {
+                        std::vector<int> tileIterations(static_cast<size_t>(tileWidth) * (tile.y1 - tile.y0));
+                        job->iterationCost += renderTileInto(view, tile, tileIterations.data(), tileWidth);
+                        return std::make_shared<const std::string>(reinterpret_cast<const char*>(tileIterations.data()),
+                                                                   tileIterations.size() * sizeof(int));
+                    }, nullptr, tileBytes);
+                    const int* tileIterations = reinterpret_cast<const int*>(data->data());
+                    for (int y = tile.y0; y < tile.y1; ++y) {
+                        std::copy_n(tileIterations + static_cast<size_t>(y - tile.y0) * tileWidth, tileWidth,
+                                    &job->iterations[static_cast<size_t>(y) * view.width + tile.x0]);
+                    }
+                    if (--job->tilesLeft > 0) return;
+
+                    // Last tile of the job: colour and write it on this worker
+                    std::vector<sf::Uint8> rgba(job->iterations.size() * 4);
+                    colourize(job->iterations.data(), job->iterations.size(), view.maxIter, 1, makePalette(job->palette), rgba.data());
+                    bool written = writePngFile(job->output, rgba.data(), view.width, view.height, 1, viewTextChunks(view));
+                    job->seconds = job->started.getElapsedTime().asSeconds();
+                    std::string hash = formatHash(hashIterations(job->iterations));
+                    std::vector<int>().swap(job->iterations);
+                    std::lock_guard<std::mutex> lock(reportMutex);
+                    if (!written) {
+                        ++failures;
+                        std::cerr << path << ":" << job->line << ": failed to write " << job->output << std::endl;
+                        return;
+                    }
+                    std::cout << job->output << ": " << view.width << "x" << view.height << " in " << job->seconds << "s, "
+                              << job->iterationCost / 1e6 / std::max(job->seconds, 1e-6f) << " Miter/s, hash " << hash << std::endl;
+                });
+            }
+        }
+    }
+    float seconds = clock.getElapsedTime().asSeconds();
+
+    uint64_t totalIterations = 0, totalPixels = 0;
+    for (auto& job : jobs) {
+        totalIterations += job->iterationCost;
+        totalPixels += static_cast<uint64_t>(job->view.width) * job->view.height;
+    }
+    TileCache::Stats stats = cache.stats();
+    std::cout << jobs.size() << " jobs, " << totalPixels / 1e6 << " Mpixel in " << seconds << "s: "
+              << totalIterations / 1e6 / std::max(seconds, 1e-6f) << " Miter/s, " << jobs.size() / std::max(seconds, 1e-6f)
+              << " jobs/s; tiles rendered " << stats.renders << ", from cache " << stats.memoryHits + stats.diskHits + stats.coalesced
+              << std::endl;
+    return failures > 0 ? 1 : 0;
+}
+
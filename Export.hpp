@@ -0,0 +1,137 @@
+#pragma once
+
+// Headless exporters: single images, zoom videos, Julia morphs and batch jobs,
+// plus a reader for frames published to shared memory
+
+#include "CommandLine.hpp"
+
+#include <string>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <list>
+#include <unordered_map>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+#include <atomic>
+#include <random>
+
+int runRender(const CommandLine& args);
+int runZoomVideo(const CommandLine& args);
+int runJuliaMorph(const CommandLine& args);
+int runBatch(const CommandLine& args);
+int runSharedFrameReader(const CommandLine& args);
+
+// Encoded tiles by key: an LRU in memory, backed by files under diskDir (if set).
+// Concurrent requests for a tile that is not cached share one render.
+class TileCache {
+public:
+    typedef std::shared_ptr<const std::string> Blob;
+
+    TileCache(size_t capacity, const std::string& diskDir) : capacity(std::max<size_t>(capacity, 1)), diskDir(diskDir) {}
+
+    // 'key' doubles as the relative file path in the disk cache. A miss renders on
+    // 'pool' if given, otherwise on the calling thread (use that from pool tasks).
+    // With 'size', a disk file of any other size is deleted and the tile rendered
+    // again; writes are atomic, so that only catches files left by another build
+    // (a different int size or tile layout).
+    Blob get(const std::string& key, const std::function<Blob()>& render, TaskPool* pool = nullptr, size_t size = 0) {
+        std::shared_future<Blob> pending;
+        std::shared_ptr<std::promise<Blob>> owned;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto hit = entries.find(key);
+            if (hit != entries.end()) {
+                recent.splice(recent.begin(), recent, hit->second.position);
+                ++memoryHits;
+                return hit->second.blob;
+            }
+            auto running = inflight.find(key);
+            if (running != inflight.end()) {
+                ++coalesced;
+                pending = running->second;
+            } else {
+                auto promise = std::make_shared<std::promise<Blob>>();
+                pending = promise->get_future().share();
+                inflight[key] = pending;
+                if (pool) pool->submit([this, key, promise, render, size] { promise->set_value(load(key, render, size)); });
+                else owned = promise;
+            }
+        }
+        if (owned) owned->set_value(load(key, render, size));
+        return pending.get();
+    }
+
+    struct Stats {
+        uint64_t memoryHits, diskHits, renders, coalesced;
+    };
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return {memoryHits, diskHits, renders, coalesced};
+    }
+
+private:
+    struct Entry {
+        Blob blob;
+        std::list<std::string>::iterator position;
+    };
+
+    Blob load(const std::string& key, const std::function<Blob()>& render, size_t size) {
+        Blob blob;
+        std::string path = diskDir.empty() ? std::string() : diskDir + "/" + key;
+        if (!path.empty()) {
+            std::ifstream in(path, std::ios::binary);
+            if (in) {
+                blob = std::make_shared<const std::string>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            if (blob && size && blob->size() != size) {
+                in.close();
+                std::error_code error;
+                std::filesystem::remove(path, error);
+                blob.reset();
+            }
+        }
+        bool fromDisk = static_cast<bool>(blob);
+        if (!blob) {
+            blob = render();
+            if (!path.empty()) store(path, *blob);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        fromDisk ? ++diskHits : ++renders;
+        inflight.erase(key);
+        recent.push_front(key);
+        entries[key] = {blob, recent.begin()};
+        if (entries.size() > capacity) {
+            entries.erase(recent.back());
+            recent.pop_back();
+        }
+        return blob;
+    }
+
+    // Written to a temporary file beside 'path' and renamed over it, so a crash or
+    // another process writing the same key never leaves a partial file under the
+    // key. A failed write leaves nothing; the tile is rendered again next time.
+    static void store(const std::string& path, const std::string& data) {
+        static const unsigned process = std::random_device()();
+        static std::atomic<unsigned> written(0);
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+        std::string temporary = path + ".tmp" + std::to_string(process) + "_" + std::to_string(written++);
+        std::ofstream out(temporary, std::ios::binary);
+        out.write(data.data(), data.size());
+        out.close();
+        if (out) std::filesystem::rename(temporary, path, error);
+        if (!out || error) std::filesystem::remove(temporary, error);
+    }
+
+    size_t capacity;
+    std::string diskDir;
+    std::mutex mutex;
+    std::list<std::string> recent; // most recently used first
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<std::string, std::shared_future<Blob>> inflight;
+    uint64_t memoryHits = 0, diskHits = 0, renders = 0, coalesced = 0;
+};
@@ -0,0 +1,336 @@
+#include "FractalCore.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+const char* formulaName(int formulaIndex) {
+    static const char* names[formulaCount] = {
+        "abs(re(z^2)) + i * im(z^2) + c",
+        "abs(re(z^2)) + i * abs(im(z^2)) + c",
+        "re(z^2) - i * im(z^2) + c",
+        "abs(Re(z) * abs(Re(z)) + Im(z)^2) + 2i * Re(z) * Im(z) + c"
+    };
+    return names[formulaIndex >= 0 && formulaIndex < formulaCount ? formulaIndex : 0];
+}
+
+template <typename T>
+int orbitPeriod(int formulaIndex, std::complex<T> z, std::complex<T> c, int maxOrbit, std::vector<std::complex<double>>& orbit) {
+    FormulaFunction<T> formula = formulaFunction<T>(formulaIndex);
+    orbit.clear();
+    int period = 0;
+    bool found = false;
+    for (; period < maxOrbit; ++period) {
+        z = formula(z, c);
+        orbit.emplace_back(z.real(), z.imag());
+        // check for repetition (simple period detection)
+        for (int j = 0; j < period; ++j) {
+            if (std::abs(orbit[period] - orbit[j]) < 1e-4) {
+                found = true;
+                break;
+            }
+        }
+        if (found || std::abs(z) > T(2)) break;
+    }
+    return period;
+}
+
+int findOrbitPeriod(const FractalView& view, std::complex<double> c, int maxOrbit, std::vector<std::complex<double>>& orbit) {
+    TRACE_ZONE("orbit");
+    std::complex<double> param = view.juliaMode ? view.juliaC : c;
+    if (view.precision == Precision::Float) {
+        return orbitPeriod<float>(view.formulaIndex, std::complex<float>(c), std::complex<float>(param), maxOrbit, orbit);
+    }
+    return orbitPeriod<double>(view.formulaIndex, c, param, maxOrbit, orbit);
+}
+
+uint64_t hashIterations(const std::vector<int>& iterations) {
+    uint64_t hash = 1469598103934665603ULL;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(iterations.data());
+    for (size_t i = 0; i < iterations.size() * sizeof(int); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string formatHash(uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4) text[i] = digits[hash & 15];
+    return text;
+}
+
+// splitmix64 finalizer
+static uint64_t mixBits(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+void sampleOffset(const Sampling& sampling, int px, int py, int sample, double& dx, double& dy) {
+    uint64_t pixel = (static_cast<uint64_t>(static_cast<uint32_t>(px)) << 32) | static_cast<uint32_t>(py);
+    uint64_t bits = mixBits(sampling.seed ^ mixBits(pixel ^ mixBits(static_cast<uint64_t>(sample))));
+    dx = static_cast<double>(bits >> 40) / (1 << 24) - 0.5;
+    dy = static_cast<double>((bits >> 16) & 0xffffff) / (1 << 24) - 0.5;
+}
+
+int samplePixel(const FractalView& view, const Sampling& sampling, int px, int py, uint64_t& cost) {
+    if (sampling.samples <= 1) {
+        int iter = iterateView(view, pixelToComplex(view, px, py));
+        cost += iter + 1;
+        return iter;
+    }
+    uint64_t sum = 0;
+    for (int s = 0; s < sampling.samples; ++s) {
+        double dx, dy;
+        sampleOffset(sampling, px, py, s, dx, dy);
+        int iter = iterateView(view, pixelToComplex(view, px + dx, py + dy));
+        sum += iter;
+        cost += iter + 1;
+    }
+    uint64_t samples = static_cast<uint64_t>(sampling.samples);
+    return static_cast<int>((sum * sampling.iterationScale() + samples / 2) / samples);
+}
+
+int renderThreadCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? static_cast<int>(n) : 4;
+}
+
+void parallelRows(int rows, const std::function<void(int)>& body, int threads) {
+    std::atomic<int> nextRow(0);
+    std::vector<std::thread> workers;
+    int threadCount = std::min(threads > 0 ? threads : renderThreadCount(), std::max(rows, 1));
+    for (int t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&]() {
+            Trace::nameThread("render thread");
+            for (int row = nextRow++; row < rows; row = nextRow++) body(row);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+TaskPool::TaskPool(int threads) {
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([this] {
+            Trace::nameThread("pool worker");
+            for (;;) {
+                std::function<void()> task;
+                Loop* loop = nullptr;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || firstLoop || !tasks.empty(); });
+                    if (firstLoop) {
+                        loop = firstLoop;
+                        ++loop->helpersActive;
+                        if (--loop->helpersWanted == 0) unqueue(loop);
+                    } else if (tasks.empty()) {
+                        return;
+                    } else {
+                        task = std::move(tasks.front());
+                        tasks.pop_front();
+                    }
+                }
+                if (!loop) {
+                    task();
+                    continue;
+                }
+                drain(*loop);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--loop->helpersActive == 0) helperDone.notify_all();
+            }
+        });
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void TaskPool::submit(std::function<void()> task) {
+    if (workers.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void TaskPool::drain(Loop& loop) {
+    for (int i = loop.next++; i < loop.count; i = loop.next++) loop.call(loop.body, i);
+}
+
+void TaskPool::unqueue(Loop* loop) {
+    Loop* previous = nullptr;
+    for (Loop* l = firstLoop; l; previous = l, l = l->nextQueued) {
+        if (l != loop) continue;
+        (previous ? previous->nextQueued : firstLoop) = l->nextQueued;
+        if (lastLoop == l) lastLoop = previous;
+        return;
+    }
+}
+
+void TaskPool::runLoop(int count, void (*call)(const void*, int), const void* body) {
+    if (count <= 0) return;
+    Loop loop;
+    loop.call = call;
+    loop.body = body;
+    loop.count = count;
+    int helpers = std::min(size(), count - 1);
+    if (helpers > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loop.helpersWanted = helpers;
+            (lastLoop ? lastLoop->nextQueued : firstLoop) = &loop;
+            lastLoop = &loop;
+        }
+        if (helpers == 1) wake.notify_one();
+        else wake.notify_all();
+    }
+    drain(loop);
+    // Every index is claimed by now. Helpers that have not joined would find no
+    // work, so they are taken off the queue; the ones running finish their
+    // last index, then the loop may leave the stack. The caller never waits
+    // for a helper to start, so nested calls from busy pool threads cannot deadlock.
+    TRACE_ZONE("wait for helpers");
+    std::unique_lock<std::mutex> lock(mutex);
+    if (loop.helpersWanted > 0) unqueue(&loop);
+    loop.helpersWanted = 0;
+    helperDone.wait(lock, [&] { return loop.helpersActive == 0; });
+}
+
+uint64_t renderInto(const FractalView& view, Kernel kernel, int* out, size_t stride, TaskPool* pool) {
+    TRACE_ZONE("render");
+    std::atomic<uint64_t> cost(0);
+    auto row = [&](int py) {
+        TRACE_ZONE("row");
+        uint64_t rowCost = 0;
+        int* line = out + static_cast<size_t>(py) * stride;
+        for (int px = 0; px < view.width; ++px) {
+            int iter = iterateView(view, pixelToComplex(view, px, py), kernel);
+            line[px] = iter;
+            rowCost += iter + 1;
+        }
+        cost += rowCost;
+    };
+    if (pool) pool->parallelFor(view.height, row);
+    else parallelRows(view.height, row);
+    return cost;
+}
+
+uint64_t renderView(const FractalView& view, std::vector<int>& iterations, TaskPool* pool) {
+    iterations.resize(static_cast<size_t>(view.width) * view.height);
+    return renderInto(view, Kernel::Scalar, iterations.data(), view.width, pool);
+}
+
+std::vector<Tile> makeTiles(int width, int height, int tileSize) {
+    std::vector<Tile> tiles;
+    for (int y = 0; y < height; y += tileSize) {
+        for (int x = 0; x < width; x += tileSize) {
+            tiles.push_back({x, y, std::min(x + tileSize, width), std::min(y + tileSize, height)});
+        }
+    }
+    return tiles;
+}
+
+uint64_t renderTileInto(const FractalView& view, const Tile& tile, int* out, size_t stride, const Sampling& sampling) {
+    TRACE_ZONE("tile");
+    uint64_t cost = 0;
+    for (int py = tile.y0; py < tile.y1; ++py) {
+        int* row = out + (py - tile.y0) * stride;
+        for (int px = tile.x0; px < tile.x1; ++px) {
+            row[px - tile.x0] = samplePixel(view, sampling, px, py, cost);
+        }
+    }
+    return cost;
+}
+
+uint64_t renderTile(const FractalView& view, std::vector<int>& iterations, const Tile& tile, const Sampling& sampling) {
+    return renderTileInto(view, tile, &iterations[static_cast<size_t>(tile.y0) * view.width + tile.x0], view.width, sampling);
+}
+
+void renderTiles(const FractalView& view, std::vector<int>& iterations, const std::vector<Tile>& tiles,
+                 const std::vector<int>& order, int threads, std::vector<uint64_t>& costs, const Sampling& sampling) {
+    iterations.resize(static_cast<size_t>(view.width) * view.height);
+    costs.resize(tiles.size());
+    parallelRows(static_cast<int>(order.size()), [&](int i) {
+        costs[order[i]] = renderTile(view, iterations, tiles[order[i]], sampling);
+    }, threads);
+}
+
+// Times the tile on the thread that renders it
+static TileCost timedTile(const FractalView& view, const Tile& tile, int* out, size_t stride, const Sampling& sampling) {
+    auto start = std::chrono::steady_clock::now();
+    TileCost cost;
+    cost.tile = tile;
+    cost.iterations = renderTileInto(view, tile, out, stride, sampling);
+    cost.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return cost;
+}
+
+void renderTiles(const FractalView& view, std::vector<int>& iterations, const std::vector<Tile>& tiles,
+                 const std::vector<int>& order, int threads, std::vector<TileCost>& costs, const Sampling& sampling) {
+    iterations.resize(static_cast<size_t>(view.width) * view.height);
+    costs.resize(tiles.size());
+    parallelRows(static_cast<int>(order.size()), [&](int i) {
+        const Tile& tile = tiles[order[i]];
+        costs[order[i]] = timedTile(view, tile, &iterations[static_cast<size_t>(tile.y0) * view.width + tile.x0], view.width, sampling);
+    }, threads);
+}
+
+uint64_t renderTilesInto(const FractalView& view, const std::vector<Tile>& tiles, int* out, size_t stride, TaskPool& pool,
+                         std::vector<TileCost>& costs) {
+    TRACE_ZONE("render");
+    costs.resize(tiles.size());
+    pool.parallelFor(static_cast<int>(tiles.size()), [&](int i) {
+        const Tile& tile = tiles[i];
+        costs[i] = timedTile(view, tile, out + static_cast<size_t>(tile.y0) * stride + tile.x0, stride, Sampling());
+    });
+    uint64_t total = 0;
+    for (const TileCost& cost : costs) total += cost.iterations;
+    return total;
+}
+
+std::vector<int> tileOrderByCost(const std::vector<uint64_t>& costs) {
+    std::vector<int> order(costs.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return costs[a] > costs[b]; });
+    return order;
+}
+
+Palette makePalette(const std::string& name) {
+    Palette palette;
+    for (int l = 0; l < 256; ++l) {
+        uint8_t r = l, g = l, b = l;
+        if (name == "fire") {
+            r = clampLevel(3 * l); g = clampLevel(3 * l - 255); b = clampLevel(3 * l - 510);
+        } else if (name == "ocean") {
+            r = clampLevel(3 * l - 510); g = clampLevel(3 * l - 255); b = clampLevel(3 * l);
+        }
+        palette.rgb[l][0] = r;
+        palette.rgb[l][1] = g;
+        palette.rgb[l][2] = b;
+    }
+    return palette;
+}
+
+void colourize(const int* iterations, size_t count, int maxIter, int iterationScale, const Palette& palette, uint8_t* rgba) {
+    TRACE_ZONE("colourize");
+    int64_t range = static_cast<int64_t>(maxIter) * iterationScale;
+    for (size_t i = 0; i < count; ++i) {
+        int level = static_cast<int>(std::min<int64_t>(255 * static_cast<int64_t>(iterations[i]) / range, 255));
+        rgba[4 * i + 0] = palette.rgb[level][0];
+        rgba[4 * i + 1] = palette.rgb[level][1];
+        rgba[4 * i + 2] = palette.rgb[level][2];
+        rgba[4 * i + 3] = 255;
+    }
+}
@@ -0,0 +1,364 @@
+#pragma once
+
+// Headless fractal core: formulas, escape-time kernels, orbit analysis,
+// colouring, tiling and scheduling. No SFML; shared by the interactive app,
+// the command line tools and the benchmarks.
+
+#include <complex>
+#include <vector>
+#include <string>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+// Formula definitions
+template <typename T>
+std::complex<T> formula1(const std::complex<T>& z, const std::complex<T>& c) {
+    // abs(re(z^2)) + i * im(z^2) + c
+    T re2 = z.real() * z.real() - z.imag() * z.imag();
+    T im2 = 2 * z.real() * z.imag();
+    return std::complex<T>(std::abs(re2), im2) + c;
+}
+template <typename T>
+std::complex<T> formula2(const std::complex<T>& z, const std::complex<T>& c) {
+    // abs(re(z^2)) + i * abs(im(z^2)) + c
+    T re2 = z.real() * z.real() - z.imag() * z.imag();
+    T im2 = 2 * z.real() * z.imag();
+    return std::complex<T>(std::abs(re2), std::abs(im2)) + c;
+}
+template <typename T>
+std::complex<T> formula3(const std::complex<T>& z, const std::complex<T>& c) {
+    // re(z^2) - i * im(z^2) + c
+    T re2 = z.real() * z.real() - z.imag() * z.imag();
+    T im2 = 2 * z.real() * z.imag();
+    return std::complex<T>(re2, -im2) + c;
+}
+template <typename T>
+std::complex<T> formula4(const std::complex<T>& z, const std::complex<T>& c) {
+    // abs(Re(z) * abs(Re(z)) + Im(z)^2) + 2i * Re(z) * Im(z) + c
+    T re_part = z.real() * std::abs(z.real()) + z.imag() * z.imag();
+    T im_part = 2 * z.real() * z.imag();
+    return std::complex<T>(std::abs(re_part), im_part) + c;
+}
+
+const int formulaCount = 4;
+
+template <typename T>
+using FormulaFunction = std::complex<T> (*)(const std::complex<T>&, const std::complex<T>&);
+
+template <typename T>
+FormulaFunction<T> formulaFunction(int formulaIndex) {
+    static const FormulaFunction<T> formulas[formulaCount] = {formula1<T>, formula2<T>, formula3<T>, formula4<T>};
+    return formulas[formulaIndex >= 0 && formulaIndex < formulaCount ? formulaIndex : 0];
+}
+
+// Human-readable formula, e.g. for the console
+const char* formulaName(int formulaIndex);
+
+// --- Views and kernels ---
+
+enum class Precision { Float, Double };
+
+// Escape-time implementations of the same iteration
+enum class Kernel {
+    Reference, // the original loop: formula through std::function, |z| > 2
+    Scalar     // formula bound at compile time, |z|^2 > 4
+};
+
+// A complete description of one rendered view, independent of any window
+struct FractalView {
+    int width = 800;
+    int height = 600;
+    int maxIter = 100;
+    int formulaIndex = 0;
+    bool juliaMode = false;
+    std::complex<double> juliaC{0.0, 0.0};
+    std::complex<double> center{0.0, 0.0}; // complex point at the middle of the image
+    double zoom = 250.0;                   // pixels per unit
+    Precision precision = Precision::Double;
+};
+
+// Escape-time loop with the formula bound at compile time
+template <typename T, std::complex<T> (*Formula)(const std::complex<T>&, const std::complex<T>&)>
+int escapeTime(std::complex<T> z, std::complex<T> c, int maxIter) {
+    int iter = 0;
+    for (; iter < maxIter; ++iter) {
+        z = Formula(z, c);
+        if (std::norm(z) > T(4)) break;
+    }
+    return iter;
+}
+
+// Iteration count for one point; the formula switch is outside the hot loop
+template <typename T>
+int iteratePoint(int formulaIndex, std::complex<T> z, std::complex<T> c, int maxIter) {
+    switch (formulaIndex) {
+    case 1: return escapeTime<T, formula2<T>>(z, c, maxIter);
+    case 2: return escapeTime<T, formula3<T>>(z, c, maxIter);
+    case 3: return escapeTime<T, formula4<T>>(z, c, maxIter);
+    default: return escapeTime<T, formula1<T>>(z, c, maxIter);
+    }
+}
+
+// Kernel::Reference for one point
+template <typename T>
+int iteratePointReference(int formulaIndex, std::complex<T> z, std::complex<T> c, int maxIter) {
+    std::function<std::complex<T>(const std::complex<T>&, const std::complex<T>&)> formula = formulaFunction<T>(formulaIndex);
+    int iter = 0;
+    for (; iter < maxIter; ++iter) {
+        z = formula(z, c);
+        if (std::abs(z) > T(2)) break;
+    }
+    return iter;
+}
+
+template <typename T>
+int iterateViewAs(const FractalView& view, std::complex<double> c, Kernel kernel) {
+    std::complex<T> z(static_cast<T>(c.real()), static_cast<T>(c.imag()));
+    std::complex<T> param = view.juliaMode ? std::complex<T>(static_cast<T>(view.juliaC.real()), static_cast<T>(view.juliaC.imag())) : z;
+    return kernel == Kernel::Reference ? iteratePointReference<T>(view.formulaIndex, z, param, view.maxIter)
+                                       : iteratePoint<T>(view.formulaIndex, z, param, view.maxIter);
+}
+
+// Iteration count at an arbitrary complex point of the view
+inline int iterateView(const FractalView& view, std::complex<double> c, Kernel kernel = Kernel::Scalar) {
+    return view.precision == Precision::Float ? iterateViewAs<float>(view, c, kernel) : iterateViewAs<double>(view, c, kernel);
+}
+
+// Complex point under pixel (px, py)
+inline std::complex<double> pixelToComplex(const FractalView& view, double px, double py) {
+    return view.center + std::complex<double>((px - view.width / 2.0) / view.zoom, (py - view.height / 2.0) / view.zoom);
+}
+
+// Hover orbit of c (Julia: of z0 = c under juliaC). Iterates until a point
+// repeats within 1e-4, the orbit escapes or maxOrbit points; returns the
+// period and leaves the visited points in 'orbit'.
+int findOrbitPeriod(const FractalView& view, std::complex<double> c, int maxOrbit, std::vector<std::complex<double>>& orbit);
+
+// FNV-1a over an iteration buffer: the content hash renders report
+uint64_t hashIterations(const std::vector<int>& iterations);
+
+// 16 hex digits
+std::string formatHash(uint64_t hash);
+
+// --- Deterministic supersampling ---
+
+// Jittered supersampling. Sample offsets come from a counter-based hash of
+// (seed, pixel, sample) rather than a generator shared between pixels, and a
+// pixel's samples are summed as integers, so the result does not depend on
+// the thread count, tile size or the order tiles are rendered in.
+struct Sampling {
+    int samples = 1; // per pixel; 1 is the pixel centre, unjittered
+    uint64_t seed = 0;
+
+    // Fixed-point scale of the mean iteration count when supersampling
+    int iterationScale() const { return samples > 1 ? 16 : 1; }
+};
+
+// Offset of one sample within pixel (px, py), each coordinate in [-0.5, 0.5)
+void sampleOffset(const Sampling& sampling, int px, int py, int sample, double& dx, double& dy);
+
+// Iteration count of pixel (px, py), times sampling.iterationScale(); adds the iterations it cost
+int samplePixel(const FractalView& view, const Sampling& sampling, int px, int py, uint64_t& cost);
+
+// --- Scheduling ---
+
+int renderThreadCount();
+
+// Run body(row) for every row in [0, rows), by default on all cores
+void parallelRows(int rows, const std::function<void(int)>& body, int threads = 0);
+
+// Fixed set of threads running queued tasks. A pool of no threads runs
+// everything on the calling thread.
+class TaskPool {
+public:
+    explicit TaskPool(int threads);
+    // Runs whatever is still queued, then joins
+    ~TaskPool();
+
+    void submit(std::function<void()> task);
+    int size() const { return static_cast<int>(workers.size()); }
+
+    // body(i) for every i in [0, count) on the pool and the calling thread;
+    // returns when all are done. Safe to call from inside a pool task. The
+    // loop lives on the caller's stack, so a call allocates nothing.
+    template <typename Body>
+    void parallelFor(int count, const Body& body) {
+        runLoop(count, [](const void* b, int i) { (*static_cast<const Body*>(b))(i); }, &body);
+    }
+
+private:
+    // A parallelFor in progress; queued until its helpers have joined
+    struct Loop {
+        void (*call)(const void* body, int i) = nullptr;
+        const void* body = nullptr;
+        int count = 0;
+        std::atomic<int> next{0};
+        int helpersWanted = 0, helpersActive = 0; // guarded by the pool's mutex
+        Loop* nextQueued = nullptr;
+    };
+    void runLoop(int count, void (*call)(const void*, int), const void* body);
+    void unqueue(Loop* loop);
+    static void drain(Loop& loop);
+
+    std::mutex mutex;
+    std::condition_variable wake, helperDone;
+    std::deque<std::function<void()>> tasks;
+    Loop* firstLoop = nullptr;
+    Loop* lastLoop = nullptr;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+// Bounded multi-producer multi-consumer ring (Vyukov); capacity rounds up to a power of two
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(T& item) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(item);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    bool tryPop(T& item) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = std::move(cell.data);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // empty
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Blocking forms: spin briefly, then yield, then sleep until the other side catches up
+    void push(T item) {
+        for (int spins = 0; !tryPush(item); ++spins) backoff(spins);
+    }
+    // False once the queue is closed and drained
+    bool pop(T& item) {
+        for (int spins = 0; !tryPop(item); ++spins) {
+            if (closed.load(std::memory_order_acquire)) return tryPop(item);
+            backoff(spins);
+        }
+        return true;
+    }
+    void close() { closed.store(true, std::memory_order_release); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    static void backoff(int spins) {
+        if (spins < 64) return;
+        if (spins < 256) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+    std::atomic<bool> closed{false};
+};
+
+// --- Rendering ---
+
+// Render the view into 'out' (rows 'stride' ints apart) with the given kernel.
+// Rows are spread over 'pool', or over temporary threads on all cores when it
+// is null. Reentrant: concurrent calls share nothing but the pool. Returns the
+// iterations it cost.
+uint64_t renderInto(const FractalView& view, Kernel kernel, int* out, size_t stride, TaskPool* pool = nullptr);
+
+// Render iteration counts for a full view (row-major, width * height)
+uint64_t renderView(const FractalView& view, std::vector<int>& iterations, TaskPool* pool = nullptr);
+
+// --- Tiles ---
+
+struct Tile {
+    int x0, y0, x1, y1; // half-open pixel rectangle
+};
+
+std::vector<Tile> makeTiles(int width, int height, int tileSize);
+
+// What one tile cost: iterations executed and wall time on the thread that rendered it
+struct TileCost {
+    Tile tile;
+    uint64_t iterations = 0;
+    double seconds = 0;
+};
+
+// Render one tile into 'out' (the tile's top-left pixel, rows 'stride' ints apart); returns the iterations it cost
+uint64_t renderTileInto(const FractalView& view, const Tile& tile, int* out, size_t stride, const Sampling& sampling = Sampling());
+
+// Render one tile into the full-view buffer
+uint64_t renderTile(const FractalView& view, std::vector<int>& iterations, const Tile& tile, const Sampling& sampling = Sampling());
+
+// Render tiles in the given order on 'threads' workers, recording each tile's cost
+void renderTiles(const FractalView& view, std::vector<int>& iterations, const std::vector<Tile>& tiles,
+                 const std::vector<int>& order, int threads, std::vector<uint64_t>& costs, const Sampling& sampling = Sampling());
+void renderTiles(const FractalView& view, std::vector<int>& iterations, const std::vector<Tile>& tiles,
+                 const std::vector<int>& order, int threads, std::vector<TileCost>& costs, const Sampling& sampling = Sampling());
+
+// Render the view tile by tile on 'pool' into 'out' (rows 'stride' ints apart),
+// recording each tile's cost; returns the iterations of the whole view
+uint64_t renderTilesInto(const FractalView& view, const std::vector<Tile>& tiles, int* out, size_t stride, TaskPool& pool,
+                         std::vector<TileCost>& costs);
+
+// Most expensive tiles first so the stragglers are cheap ones
+std::vector<int> tileOrderByCost(const std::vector<uint64_t>& costs);
+
+// --- Colouring ---
+
+// 256-entry lookup indexed by the grey level of the iteration count
+struct Palette {
+    uint8_t rgb[256][3];
+};
+
+inline uint8_t clampLevel(int v) {
+    return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// "grey" (the interactive ramp), "fire" or "ocean"
+Palette makePalette(const std::string& name);
+
+// Iteration counts (scaled by iterationScale) to opaque RGBA
+void colourize(const int* iterations, size_t count, int maxIter, int iterationScale, const Palette& palette, uint8_t* rgba);
@@ -0,0 +1,233 @@
+#include "Hud.hpp"
+#include "Allocations.hpp"
+#include "Backends.hpp"
+#include "SessionStats.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+// 3x5 glyphs, one row of three bits per entry (high bit on the left)
+static const uint8_t* glyph(char c) {
+    static const uint8_t digits[10][5] = {
+        {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 7, 1, 7}, {5, 5, 7, 1, 1},
+        {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 1, 1}, {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7}};
+    static const uint8_t letters[26][5] = {
+        {2, 5, 7, 5, 5}, {6, 5, 6, 5, 6}, {3, 4, 4, 4, 3}, {6, 5, 5, 5, 6}, {7, 4, 6, 4, 7}, {7, 4, 6, 4, 4},
+        {3, 4, 5, 5, 3}, {5, 5, 7, 5, 5}, {7, 2, 2, 2, 7}, {1, 1, 1, 5, 2}, {5, 5, 6, 5, 5}, {4, 4, 4, 4, 7},
+        {5, 7, 7, 5, 5}, {6, 5, 5, 5, 5}, {2, 5, 5, 5, 2}, {6, 5, 6, 4, 4}, {2, 5, 5, 6, 3}, {6, 5, 6, 5, 5},
+        {3, 4, 2, 1, 6}, {7, 2, 2, 2, 2}, {5, 5, 5, 5, 7}, {5, 5, 5, 5, 2}, {5, 5, 7, 7, 5}, {5, 5, 2, 5, 5},
+        {5, 5, 2, 2, 2}, {7, 1, 2, 4, 7}};
+    static const uint8_t dot[5] = {0, 0, 0, 0, 2}, percent[5] = {5, 1, 2, 4, 5}, slash[5] = {1, 1, 2, 4, 4},
+                         colon[5] = {0, 2, 0, 2, 0}, dash[5] = {0, 0, 7, 0, 0};
+    unsigned char u = static_cast<unsigned char>(c);
+    if (std::isdigit(u)) return digits[c - '0'];
+    if (std::isalpha(u)) return letters[std::toupper(u) - 'A'];
+    switch (c) {
+    case '.': return dot;
+    case '%': return percent;
+    case '/': return slash;
+    case ':': return colon;
+    case '-': return dash;
+    default: return nullptr;
+    }
+}
+
+static const float pixel = 2.f;             // screen pixels per font pixel
+static const float advance = 4 * pixel;     // per character
+static const float lineHeight = 7 * pixel;
+static const float budgetMs = 1000.f / 60;  // bar length of one frame at 60 Hz
+static const float barScale = 120.f / budgetMs;
+
+static void rectangle(sf::VertexArray& quads, float x, float y, float w, float h, sf::Color colour) {
+    quads.append(sf::Vertex(sf::Vector2f(x, y), colour));
+    quads.append(sf::Vertex(sf::Vector2f(x + w, y), colour));
+    quads.append(sf::Vertex(sf::Vector2f(x + w, y + h), colour));
+    quads.append(sf::Vertex(sf::Vector2f(x, y + h), colour));
+}
+
+static void text(sf::VertexArray& out, const char* line, float x, float y, sf::Color colour) {
+    for (size_t i = 0; line[i]; ++i) {
+        const uint8_t* rows = glyph(line[i]);
+        if (!rows) continue;
+        for (int r = 0; r < 5; ++r) {
+            for (int b = 0; b < 3; ++b) {
+                if (rows[r] & (4 >> b)) rectangle(out, x + i * advance + b * pixel, y + r * pixel, pixel, pixel, colour);
+            }
+        }
+    }
+}
+
+static const char* stageNames[FrameHud::StageCount] = {"EVENTS", "HOVER", "COMPUTE", "UPLOAD", "OVERLAY", "AUDIO", "DISPLAY"};
+
+FrameHud::FrameHud() : quads(sf::Quads) {
+    // Room for every glyph pixel the HUD can show, so drawing it never grows the array
+    quads.resize(1 << 15);
+    quads.clear();
+    for (int s = 0; s < StageCount; ++s) Allocations::name(s, stageNames[s]);
+    Allocations::enter(current);
+    frameStartAllocations = Allocations::total();
+}
+
+// The stages double as trace zones and allocation subsystems of the UI thread
+void FrameHud::closeStage() {
+    frameTimes[current] += clock.restart().asSeconds() * 1000.f;
+    if (Trace::enabled()) {
+        int64_t now = Trace::now();
+        Trace::record(stageNames[current], stageStart, now);
+        stageStart = now;
+    }
+}
+
+void FrameHud::enter(Stage stage) {
+    if (stage == current) return;
+    closeStage();
+    current = stage;
+    Allocations::enter(stage);
+}
+
+void FrameHud::endFrame() {
+    closeStage();
+    std::copy(frameTimes, frameTimes + StageCount, recent[recorded % history]);
+    std::fill(frameTimes, frameTimes + StageCount, 0.f);
+    ++recorded;
+    current = Events;
+    Allocations::enter(Events);
+    AllocationCounts now = Allocations::total();
+    lastFrameAllocations = now - frameStartAllocations;
+    frameStartAllocations = now;
+}
+
+void FrameHud::renderStats(uint64_t iterations, float seconds, double maxIterFraction) {
+    miterPerSecond = iterations / 1e6f / std::max(seconds, 1e-6f);
+    interior = maxIterFraction;
+}
+
+float FrameHud::average(int stage) const {
+    int frames = std::min(recorded, history);
+    float sum = 0;
+    for (int f = 0; f < frames; ++f) sum += recent[f][stage];
+    return frames ? sum / frames : 0.f;
+}
+
+void FrameHud::draw(WindowBackend& window) {
+    if (!visible) return;
+    static const sf::Color colours[StageCount] = {sf::Color(120, 120, 255), sf::Color(0, 200, 0), sf::Color(255, 80, 80),
+                                                  sf::Color(255, 160, 0), sf::Color(200, 0, 200), sf::Color(0, 200, 200),
+                                                  sf::Color(200, 200, 200)};
+    const float left = 8, top = 8, labelWidth = 8 * advance, valueWidth = 9 * advance;
+    const float width = labelWidth + valueWidth + 2 * budgetMs * barScale;
+    int latencyKinds = 0;
+    for (int k = 0; session && k < SessionStats::InputKindCount; ++k) latencyKinds += session->effectLatency(k).count() > 0;
+    const int infoLines = Allocations::tracked() ? 4 : 3;
+    // Title, one line per kind of input seen, then the histogram bars (3 lines) and their labels
+    const float latencyLines = latencyKinds ? 0.5f + 1 + latencyKinds + 4 : 0;
+    quads.clear();
+    rectangle(quads, left - 4, top - 4, width + 8, (StageCount + 1 + infoLines + latencyLines) * lineHeight + 4, sf::Color(0, 0, 0, 160));
+
+    char value[32];
+    float total = 0;
+    for (int s = 0; s < StageCount; ++s) {
+        float ms = average(s);
+        total += ms;
+        float y = top + s * lineHeight;
+        std::snprintf(value, sizeof(value), "%6.2f MS", ms);
+        text(quads, stageNames[s], left, y, sf::Color::White);
+        text(quads, value, left + labelWidth, y, sf::Color::White);
+        rectangle(quads, left + labelWidth + valueWidth, y, std::min(ms * barScale, 2 * budgetMs * barScale), 5 * pixel, colours[s]);
+    }
+    // Frame budget marker
+    rectangle(quads, left + labelWidth + valueWidth + budgetMs * barScale, top, 1, StageCount * lineHeight, sf::Color::Yellow);
+
+    float y = top + (StageCount + 0.5f) * lineHeight;
+    std::snprintf(value, sizeof(value), "FRAME %.2f MS", total);
+    text(quads, value, left, y, sf::Color::Yellow);
+    std::snprintf(value, sizeof(value), "RENDER %.1f MITER/S", miterPerSecond);
+    text(quads, value, left, y + lineHeight, sf::Color::White);
+    std::snprintf(value, sizeof(value), "AT MAXITER %.1f%%", 100 * interior);
+    text(quads, value, left, y + 2 * lineHeight, sf::Color::White);
+    if (Allocations::tracked()) {
+        std::snprintf(value, sizeof(value), "ALLOC %llu / %.1f KB", static_cast<unsigned long long>(lastFrameAllocations.allocations),
+                      lastFrameAllocations.bytes / 1024.0);
+        text(quads, value, left, y + 3 * lineHeight, lastFrameAllocations.allocations ? sf::Color::Red : sf::Color::White);
+    }
+    if (latencyKinds) drawLatency(left, y + (infoLines + 0.5f) * lineHeight, width);
+    window.draw(quads);
+}
+
+// Input-to-display latency of the session so far: p50 and p95 (bucket tops)
+// per kind of input, and the histogram of all of them together
+void FrameHud::drawLatency(float left, float y, float width) {
+    char line[48];
+    text(quads, "INPUT TO DISPLAY MS", left, y, sf::Color::Yellow);
+    uint64_t buckets[LatencyHistogram::bucketCount] = {}, tallest = 1;
+    for (int k = 0; k < SessionStats::InputKindCount; ++k) {
+        const LatencyHistogram& histogram = session->effectLatency(k);
+        if (histogram.count() == 0) continue;
+        y += lineHeight;
+        std::snprintf(line, sizeof(line), "%-8s P50 %.1f P95 %.1f N %llu", SessionStats::inputKindName(k), histogram.percentile(50),
+                      histogram.percentile(95), static_cast<unsigned long long>(histogram.count()));
+        text(quads, line, left, y, sf::Color::White);
+        for (int b = 0; b < LatencyHistogram::bucketCount; ++b) {
+            buckets[b] += histogram.count(b);
+            tallest = std::max(tallest, buckets[b]);
+        }
+    }
+    const float column = width / LatencyHistogram::bucketCount, barTop = y + lineHeight, barHeight = 3 * lineHeight - pixel;
+    for (int b = 0; b < LatencyHistogram::bucketCount; ++b) {
+        float x = left + b * column, h = barHeight * buckets[b] / tallest;
+        rectangle(quads, x, barTop + barHeight - h, column - 2 * pixel, h, sf::Color(0, 200, 200));
+        double limit = LatencyHistogram::bucketLimit(b);
+        if (limit > 0) std::snprintf(line, sizeof(line), "%.0f", limit);
+        else std::snprintf(line, sizeof(line), "MORE");
+        text(quads, line, x, barTop + 3 * lineHeight, sf::Color::White);
+    }
+}
+
+TileHeatmap::TileHeatmap() : tiles(sf::Quads), legend(sf::Quads) {}
+
+// 0 blue, 0.5 green, 1 red
+static sf::Color heat(double t, sf::Uint8 alpha) {
+    t = std::min(std::max(t, 0.0), 1.0);
+    sf::Uint8 r = static_cast<sf::Uint8>(255 * std::max(0.0, 2 * t - 1));
+    sf::Uint8 b = static_cast<sf::Uint8>(255 * std::max(0.0, 1 - 2 * t));
+    return sf::Color(r, static_cast<sf::Uint8>(255 - r - b), b, alpha);
+}
+
+void TileHeatmap::update(const std::vector<TileCost>& costs) {
+    tiles.clear();
+    legend.clear();
+    if (costs.empty()) return;
+    double slowest = 0;
+    uint64_t fewest = costs[0].iterations, most = 0;
+    int viewWidth = 0;
+    for (const TileCost& cost : costs) {
+        viewWidth = std::max(viewWidth, cost.tile.x1);
+        slowest = std::max(slowest, cost.seconds);
+        fewest = std::min(fewest, cost.iterations);
+        most = std::max(most, cost.iterations);
+    }
+    for (const TileCost& cost : costs) {
+        const Tile& t = cost.tile;
+        rectangle(tiles, static_cast<float>(t.x0), static_cast<float>(t.y0), static_cast<float>(t.x1 - t.x0),
+                  static_cast<float>(t.y1 - t.y0), heat(slowest > 0 ? cost.seconds / slowest : 0, 96));
+        // Tile borders
+        rectangle(tiles, static_cast<float>(t.x0), static_cast<float>(t.y0), static_cast<float>(t.x1 - t.x0), 1, sf::Color(0, 0, 0, 64));
+        rectangle(tiles, static_cast<float>(t.x0), static_cast<float>(t.y0), 1, static_cast<float>(t.y1 - t.y0), sf::Color(0, 0, 0, 64));
+    }
+
+    char line[64];
+    const float right = viewWidth - 8.f, top = 8, width = 24 * advance;
+    rectangle(legend, right - width - 4, top - 4, width + 8, 2 * lineHeight + 4, sf::Color(0, 0, 0, 160));
+    std::snprintf(line, sizeof(line), "SLOWEST TILE %.2f MS", 1000 * slowest);
+    text(legend, line, right - width, top, sf::Color::White);
+    std::snprintf(line, sizeof(line), "ITER %llu-%llu", static_cast<unsigned long long>(fewest), static_cast<unsigned long long>(most));
+    text(legend, line, right - width, top + lineHeight, sf::Color::White);
+}
+
+void TileHeatmap::draw(WindowBackend& window) {
+    if (!visible) return;
+    window.draw(tiles);
+    window.draw(legend);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// Toggleable overlays: the rolling time of each stage of the main loop, plus
+// the throughput and interior fraction of the latest render (and the heap
+// allocations of the last frame in a tracking build), and a heatmap of
+// what each tile of that render cost. Text uses a built-in 3x5 pixel font, so
+// they need no font file.
+
+#include "Allocations.hpp"
+#include "FractalCore.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
+
+class WindowBackend;
+class SessionStats;
+
+class FrameHud {
+public:
+    enum Stage { Events, Hover, Compute, Upload, Overlay, Audio, Display, StageCount };
+
+    FrameHud();
+
+    // Time (and the UI thread's allocations) from now on count towards 'stage', until the next enter() or endFrame()
+    void enter(Stage stage);
+    void endFrame();
+
+    // Latest render: iterations it cost, its kernel time and the share of pixels at maxIter
+    void renderStats(uint64_t iterations, float seconds, double maxIterFraction);
+
+    // Also shows the session's input-to-display latency histograms
+    const SessionStats* session = nullptr;
+
+    bool visible = false;
+    void draw(WindowBackend& window);
+
+private:
+    static constexpr int history = 60; // frames averaged
+
+    void closeStage();
+    float average(int stage) const;
+    void drawLatency(float left, float y, float width);
+
+    sf::Clock clock;
+    Stage current = Events;
+    int64_t stageStart = 0; // trace time
+    float frameTimes[StageCount] = {};
+    float recent[history][StageCount] = {};
+    int recorded = 0;
+    AllocationCounts frameStartAllocations, lastFrameAllocations;
+    float miterPerSecond = 0;
+    double interior = 0;
+    sf::VertexArray quads;
+};
+
+// Tiles tinted from blue (cheapest) to red (slowest wall time), with the
+// slowest tile's time and the spread of iterations in the corner
+class TileHeatmap {
+public:
+    TileHeatmap();
+
+    void update(const std::vector<TileCost>& costs);
+
+    bool visible = false;
+    void draw(WindowBackend& window);
+
+private:
+    sf::VertexArray tiles;
+    sf::VertexArray legend;
+};
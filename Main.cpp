@@ -1,21 +1,36 @@
+#include "FractalCore.hpp"
+#include "Encoding.hpp"
+#include "CommandLine.hpp"
+#include "Backends.hpp"
+#include "SharedFrameRing.hpp"
+#include "SessionStats.hpp"
+#include "Hud.hpp"
+#include "Trace.hpp"
+
 #include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
 #include <complex>
 #include <vector>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
-#include <functional>
-
-// Generate a sine wave buffer for the sound
-sf::SoundBuffer generateSineBuffer(int sampleRate, float duration, float frequency) {
+#include <fstream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <ctime>
+#include <cstdio>
+
+// Generate sine wave samples for the sound, into a buffer reused from tone to tone
+void generateSineSamples(int sampleRate, float duration, float frequency, std::vector<sf::Int16>& samples) {
+    TRACE_ZONE("audio samples");
     int count = static_cast<int>(sampleRate * duration);
-    std::vector<sf::Int16> samples(count);
+    samples.resize(count);
     for (int i = 0; i < count; ++i) {
         samples[i] = static_cast<sf::Int16>(32760 * std::sin(2 * M_PI * frequency * i / sampleRate));
     }
-    sf::SoundBuffer buffer;
-    buffer.loadFromSamples(samples.data(), samples.size(), 1, sampleRate);
-    return buffer;
 }
 
 // Helper to map screen to complex plane
@@ -26,78 +41,162 @@ std::complex<float> screenToComplex(int x, int y, float zoom, sf::Vector2f offse
     );
 }
 
-// Formula definitions
-std::complex<float> formula1(const std::complex<float>& z, const std::complex<float>& c) {
-    // abs(re(z^2)) + i * im(z^2) + c
-    float re2 = z.real() * z.real() - z.imag() * z.imag();
-    float im2 = 2 * z.real() * z.imag();
-    return std::complex<float>(std::abs(re2), im2) + c;
-}
-std::complex<float> formula2(const std::complex<float>& z, const std::complex<float>& c) {
-    // abs(re(z^2)) + i * abs(im(z^2)) + c
-    float re2 = z.real() * z.real() - z.imag() * z.imag();
-    float im2 = 2 * z.real() * z.imag();
-    return std::complex<float>(std::abs(re2), std::abs(im2)) + c;
-}
-std::complex<float> formula3(const std::complex<float>& z, const std::complex<float>& c) {
-    // re(z^2) - i * im(z^2) + c
-    float re2 = z.real() * z.real() - z.imag() * z.imag();
-    float im2 = 2 * z.real() * z.imag();
-    return std::complex<float>(re2, -im2) + c;
-}
-std::complex<float> formula4(const std::complex<float>& z, const std::complex<float>& c) {
-    // abs(Re(z) * abs(Re(z)) + Im(z)^2) + 2i * Re(z) * Im(z) + c
-    float re_part = z.real() * std::abs(z.real()) + z.imag() * z.imag();
-    float im_part = 2 * z.real() * z.imag();
-    return std::complex<float>(std::abs(re_part), im_part) + c;
-}
+// --- Screenshots ---
+
+// Colours, encodes and writes captured frames on its own thread
+class ScreenshotWriter {
+public:
+    ScreenshotWriter() : worker([this] { run(); }) {}
+    ~ScreenshotWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    // Takes a reference to the iteration buffer; the caller must not write into it afterwards
+    void capture(std::shared_ptr<const std::vector<int>> iterations, const FractalView& view) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back({std::move(iterations), view});
+        }
+        wake.notify_one();
+    }
+
+private:
+    struct Shot {
+        std::shared_ptr<const std::vector<int>> iterations;
+        FractalView view;
+    };
+
+    void run() {
+        Trace::nameThread("screenshots");
+        Palette palette = makePalette("grey");
+        std::vector<sf::Uint8> rgba;
+        for (int count = 1;; ++count) {
+            Shot shot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || !pending.empty(); });
+                if (pending.empty()) return;
+                shot = std::move(pending.front());
+                pending.pop_front();
+            }
+            TRACE_ZONE("screenshot");
+            rgba.resize(shot.iterations->size() * 4);
+            colourize(shot.iterations->data(), shot.iterations->size(), shot.view.maxIter, 1, palette, rgba.data());
+            char name[64];
+            std::time_t now = std::time(nullptr);
+            size_t length = std::strftime(name, sizeof(name), "screenshot_%Y%m%d_%H%M%S", std::localtime(&now));
+            std::snprintf(name + length, sizeof(name) - length, "_%d.png", count);
+            // Two deflate threads so the interactive renderer keeps the rest of the cores
+            if (writePngFile(name, rgba.data(), shot.view.width, shot.view.height, 2, viewTextChunks(shot.view))) {
+                std::cout << "Saved " << name << std::endl;
+            } else {
+                std::cerr << "Failed to write " << name << std::endl;
+            }
+        }
+    }
 
-int main() {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Shot> pending;
+    bool stopping = false;
+    std::thread worker;
+};
+
+// [--null-window SCRIPT] [--audio-out FILE.wav]: replay scripted input without a
+// display (see NullWindow) and/or record the tones instead of playing them.
+// [--shm NAME [--shm-slots N]]: publish every computed frame to a shared-memory ring.
+// [--hud]: start with the stage timing overlay shown (H toggles it).
+// [--tile N]: render in NxN tiles (default 32); [--heatmap] starts with the tile
+// cost overlay shown (T toggles it) and [--tile-costs FILE.csv] logs every tile.
+// [--trace FILE.json]: record a timeline of the loop and the workers.
+// [--record FILE]: write the session's input as a --null-window script. Replays
+// take [--frame-step MS] for a deterministic virtual clock, and report frame
+// times, input latency and frames over [--frame-budget MS] (also [--report FILE.json]).
+int main(int argc, char** argv) {
+    CommandLine args(argc, argv, 1);
+    if (args.has("trace")) Trace::start();
+    Trace::nameThread("ui");
     const int width = 800;
     const int height = 600;
     const int maxIter = 100;
     float zoom = 250.0f;
     sf::Vector2f offset(0.f, 0.f);
 
-    sf::RenderWindow window(sf::VideoMode(width, height), "Celtic Orbit Explorer (Zoom, Pan, Mouse-Direct Orbit Period, Julia/J-explore, Formula Switch 1-4)");
-    sf::Image fractalImage;
-    fractalImage.create(width, height, sf::Color::Black);
+    bool headless = args.has("null-window");
+    std::unique_ptr<WindowBackend> window;
+    if (headless) window.reset(new NullWindow(args.get("null-window", ""), args.getDouble("frame-step", 0)));
+    else window.reset(new SfmlWindow(width, height, "Celtic Orbit Explorer (Zoom, Pan, Mouse-Direct Orbit Period, Julia/J-explore, Formula Switch 1-4)"));
+    if (args.has("record")) window.reset(new RecordingWindow(std::move(window), args.get("record", "session.txt")));
+    std::unique_ptr<AudioSink> audio;
+    if (args.has("audio-out")) audio.reset(new WavAudioSink(args.get("audio-out", "tones.wav"), *window));
+    else if (headless) audio.reset(new NullAudioSink());
+    else audio.reset(new SpeakerSink());
 
     // Julia mode state
     bool juliaMode = false;
     std::complex<float> juliaC(0, 0);
 
-    // Formulas vector and current index
-    std::vector<std::function<std::complex<float>(const std::complex<float>&, const std::complex<float>&)>> formulas = {
-        formula1, formula2, formula3, formula4
-    };
+    // Current formula
     int formulaIndex = 0;
 
+    // Render threads; the core spreads each frame's tiles over them
+    TaskPool renderPool(renderThreadCount());
+    const std::vector<Tile> tiles = makeTiles(width, height, std::max(args.getInt("tile", 32), 8));
+    std::vector<TileCost> tileCosts;
+    Palette palette = makePalette("grey");
+    std::vector<sf::Uint8> rgba(width * height * 4);
+
+    // Iteration counts of the displayed frame. Screenshots hold a reference instead
+    // of a copy, so a shared buffer is replaced rather than overwritten.
+    auto iterationBuffer = std::make_shared<std::vector<int>>(width * height);
+    FractalView displayedView; // parameters the buffer was computed with
+    displayedView.precision = Precision::Float;
+    ScreenshotWriter screenshots;
+    std::unique_ptr<SharedFrameRing> sharedFrames;
+    if (args.has("shm")) sharedFrames = SharedFrameRing::create(args.get("shm", "celticframes"), args.getInt("shm-slots", 4), width * height);
+
+    FrameHud hud;
+    hud.visible = args.has("hud");
+    TileHeatmap heatmap;
+    heatmap.visible = args.has("heatmap");
+    std::ofstream tileCostLog;
+    if (args.has("tile-costs")) {
+        tileCostLog.open(args.get("tile-costs", "tiles.csv"));
+        writeTileCostsHeader(tileCostLog);
+    }
+    int renderCount = 0;
+
     // Precompute fractal image based on zoom and offset
     auto computeFractal = [&](float zoom, sf::Vector2f offset, bool juliaMode, std::complex<float> juliaC, int formulaIndex) {
-        for (int px = 0; px < width; ++px) {
-            for (int py = 0; py < height; ++py) {
-                std::complex<float> c = screenToComplex(px, py, zoom, offset, width, height);
-                std::complex<float> z = juliaMode ? c : c;
-                std::complex<float> cc = juliaMode ? juliaC : c;
-                int iter = 0;
-                for (; iter < maxIter; ++iter) {
-                    z = formulas[formulaIndex](z, cc);
-                    if (std::abs(z) > 2.0f) break;
-                }
-                sf::Uint8 color = static_cast<sf::Uint8>(255 * iter / maxIter);
-                fractalImage.setPixel(px, py, sf::Color(color, color, color));
-            }
-        }
+        if (iterationBuffer.use_count() > 1) iterationBuffer = std::make_shared<std::vector<int>>(width * height);
+        std::vector<int>& iterations = *iterationBuffer;
+        displayedView.width = width;
+        displayedView.height = height;
+        displayedView.maxIter = maxIter;
+        displayedView.formulaIndex = formulaIndex;
+        displayedView.juliaMode = juliaMode;
+        displayedView.juliaC = std::complex<double>(juliaC.real(), juliaC.imag());
+        displayedView.center = std::complex<double>(offset.x / zoom, offset.y / zoom);
+        displayedView.zoom = zoom;
+        sf::Clock renderClock;
+        uint64_t cost = renderTilesInto(displayedView, tiles, iterations.data(), width, renderPool, tileCosts);
+        float renderSeconds = renderClock.getElapsedTime().asSeconds();
+        heatmap.update(tileCosts);
+        if (tileCostLog.is_open()) writeTileCostsCsv(tileCostLog, renderCount, displayedView, tileCosts);
+        ++renderCount;
+        size_t interior = std::count(iterations.begin(), iterations.end(), maxIter);
+        hud.renderStats(cost, renderSeconds, double(interior) / iterations.size());
+        if (sharedFrames) sharedFrames->publish(displayedView, iterations.data());
+        colourize(iterations.data(), iterations.size(), maxIter, 1, palette, rgba.data());
     };
 
     computeFractal(zoom, offset, juliaMode, juliaC, formulaIndex);
-    sf::Texture fractalTexture;
-    fractalTexture.loadFromImage(fractalImage);
-    sf::Sprite fractalSprite(fractalTexture);
-
-    sf::Sound sound;
-    sf::SoundBuffer buffer;
+    window->setFrame(rgba.data(), width, height);
 
     int lastPeriod = -1; // To avoid printing the same period too many times
 
@@ -110,26 +209,43 @@ int main() {
     sf::Vector2f dragStartOffset;
 
     // For period display
+    const int maxOrbit = 1000;
     int mousePeriod = -1;
-    std::vector<std::complex<float>> mouseOrbit;
-
-    // Formula info display
-    std::vector<std::string> formulaNames = {
-        "abs(re(z^2)) + i * im(z^2) + c",
-        "abs(re(z^2)) + i * abs(im(z^2)) + c",
-        "re(z^2) - i * im(z^2) + c",
-        "abs(Re(z) * abs(Re(z)) + Im(z)^2) + 2i * Re(z) * Im(z) + c"
-    };
-
-    while (window.isOpen()) {
+    std::vector<std::complex<double>> mouseOrbit;
+
+    // Everything the overlays and the tone need each frame is made here once and
+    // reset per frame, so a warm loop allocates nothing
+    mouseOrbit.reserve(maxOrbit + 1);
+    sf::VertexArray orbitLine(sf::LineStrip);
+    orbitLine.resize(maxOrbit + 1);
+    sf::CircleShape juliaMarker(8.f);
+    juliaMarker.setFillColor(sf::Color::Blue);
+    juliaMarker.setOrigin(8.f, 8.f);
+    sf::CircleShape marker(8.f);
+    marker.setFillColor(sf::Color::Red);
+    marker.setOrigin(8.f, 8.f);
+    const int toneRate = 44100;
+    const float toneSeconds = 0.08f;
+    std::vector<sf::Int16> toneSamples;
+    toneSamples.reserve(static_cast<size_t>(toneRate * toneSeconds) + 1);
+
+    // Frame and input timings for the summary of a headless or recorded run
+    SessionStats stats(args.getDouble("frame-budget", 1000.0 / 60));
+    hud.session = &stats;
+
+    while (window->isOpen()) {
+        TRACE_ZONE("frame");
+        hud.enter(FrameHud::Events);
         sf::Event event;
-        while (window.pollEvent(event)) {
+        while (window->pollEvent(event)) {
             if (event.type == sf::Event::Closed)
-                window.close();
+                window->close();
+            else
+                stats.inputPolled();
 
             // Mouse wheel zooming
             if (event.type == sf::Event::MouseWheelScrolled) {
-                sf::Vector2i mouse = sf::Mouse::getPosition(window);
+                sf::Vector2i mouse = window->mousePosition();
                 std::complex<float> beforeZoom = screenToComplex(mouse.x, mouse.y, zoom, offset, width, height);
 
                 if (event.mouseWheelScroll.delta > 0) {
@@ -144,14 +260,15 @@ int main() {
                 offset.y += (afterZoom.imag() - beforeZoom.imag()) * zoom;
 
                 needsUpdate = true;
+                stats.viewInput(SessionStats::Wheel);
             }
 
             // ALT + LMB drag start
             if (event.type == sf::Event::MouseButtonPressed &&
                 event.mouseButton.button == sf::Mouse::Left &&
-                (sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt) || sf::Keyboard::isKeyPressed(sf::Keyboard::RAlt))) {
+                (window->isKeyPressed(sf::Keyboard::LAlt) || window->isKeyPressed(sf::Keyboard::RAlt))) {
                 dragging = true;
-                lastMousePos = sf::Mouse::getPosition(window);
+                lastMousePos = window->mousePosition();
                 dragStartOffset = offset;
             }
 
@@ -160,6 +277,17 @@ int main() {
                 dragging = false;
             }
 
+            // Inputs applied after the event loop, timed from here to the frame that shows them
+            if (event.type == sf::Event::MouseMoved) {
+                if (dragging && (window->isKeyPressed(sf::Keyboard::LAlt) || window->isKeyPressed(sf::Keyboard::RAlt)))
+                    stats.viewInput(SessionStats::Drag);
+                else if (window->isKeyPressed(sf::Keyboard::J))
+                    stats.viewInput(SessionStats::Julia);
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::J) {
+                stats.viewInput(SessionStats::Julia);
+            }
+
             // If window loses focus, stop dragging
             if (event.type == sf::Event::LostFocus) {
                 dragging = false;
@@ -169,99 +297,92 @@ int main() {
             if (event.type == sf::Event::KeyPressed) {
                 if (event.key.code == sf::Keyboard::Num1 || event.key.code == sf::Keyboard::Numpad1) {
                     formulaIndex = 0; needsUpdate = true;
-                    std::cout << "Switched to formula 1: " << formulaNames[0] << std::endl;
+                    stats.viewInput(SessionStats::Formula);
+                    std::cout << "Switched to formula 1: " << formulaName(0) << std::endl;
                 }
                 if (event.key.code == sf::Keyboard::Num2 || event.key.code == sf::Keyboard::Numpad2) {
                     formulaIndex = 1; needsUpdate = true;
-                    std::cout << "Switched to formula 2: " << formulaNames[1] << std::endl;
+                    stats.viewInput(SessionStats::Formula);
+                    std::cout << "Switched to formula 2: " << formulaName(1) << std::endl;
                 }
                 if (event.key.code == sf::Keyboard::Num3 || event.key.code == sf::Keyboard::Numpad3) {
                     formulaIndex = 2; needsUpdate = true;
-                    std::cout << "Switched to formula 3: " << formulaNames[2] << std::endl;
+                    stats.viewInput(SessionStats::Formula);
+                    std::cout << "Switched to formula 3: " << formulaName(2) << std::endl;
                 }
                 if (event.key.code == sf::Keyboard::Num4 || event.key.code == sf::Keyboard::Numpad4) {
                     formulaIndex = 3; needsUpdate = true;
-                    std::cout << "Switched to formula 4: " << formulaNames[3] << std::endl;
+                    stats.viewInput(SessionStats::Formula);
+                    std::cout << "Switched to formula 4: " << formulaName(3) << std::endl;
+                }
+                // Screenshot of the frame on screen; saved in the background
+                if (event.key.code == sf::Keyboard::P) {
+                    screenshots.capture(iterationBuffer, displayedView);
+                }
+                if (event.key.code == sf::Keyboard::H) {
+                    hud.visible = !hud.visible;
+                }
+                if (event.key.code == sf::Keyboard::T) {
+                    heatmap.visible = !heatmap.visible;
                 }
             }
         }
 
         // Camera dragging logic
-        if (dragging && (sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt) || sf::Keyboard::isKeyPressed(sf::Keyboard::RAlt))) {
-            sf::Vector2i mouse = sf::Mouse::getPosition(window);
+        if (dragging && (window->isKeyPressed(sf::Keyboard::LAlt) || window->isKeyPressed(sf::Keyboard::RAlt))) {
+            sf::Vector2i mouse = window->mousePosition();
             sf::Vector2i delta = mouse - lastMousePos;
             offset = dragStartOffset - sf::Vector2f(delta.x, delta.y);
             needsUpdate = true;
         }
 
         // --- Julia mode handling ---
-        bool newJuliaMode = sf::Keyboard::isKeyPressed(sf::Keyboard::J);
+        bool newJuliaMode = window->isKeyPressed(sf::Keyboard::J);
         if (newJuliaMode && !juliaMode) {
             // Just entered Julia mode, set Julia point to mouse
-            sf::Vector2i mouse = sf::Mouse::getPosition(window);
+            sf::Vector2i mouse = window->mousePosition();
             juliaC = screenToComplex(mouse.x, mouse.y, zoom, offset, width, height);
             needsUpdate = true;
         } else if (newJuliaMode && juliaMode) {
             // While holding J, update Julia point to mouse
-            sf::Vector2i mouse = sf::Mouse::getPosition(window);
+            sf::Vector2i mouse = window->mousePosition();
             juliaC = screenToComplex(mouse.x, mouse.y, zoom, offset, width, height);
             needsUpdate = true;
         }
         juliaMode = newJuliaMode;
 
         // --- Get orbit period at mouse at all times ---
-        sf::Vector2i mouse = sf::Mouse::getPosition(window);
+        hud.enter(FrameHud::Hover);
+        sf::Vector2i mouse = window->mousePosition();
         mousePeriod = -1;
         mouseOrbit.clear();
         if (mouse.x >= 0 && mouse.x < width && mouse.y >= 0 && mouse.y < height) {
             std::complex<float> c = screenToComplex(mouse.x, mouse.y, zoom, offset, width, height);
-            std::complex<float> z, cc;
-            if (juliaMode) {
-                z = c;
-                cc = juliaC;
-            } else {
-                z = c;
-                cc = c;
-            }
-            int period = 0;
-            int maxOrbit = 1000;
-            std::vector<std::complex<float>> orbit;
-            bool found = false;
-            for (; period < maxOrbit; ++period) {
-                z = formulas[formulaIndex](z, cc);
-                orbit.push_back(z);
-                // check for repetition (simple period detection)
-                for (int j = 0; j < period; ++j) {
-                    if (std::abs(z - orbit[j]) < 1e-4) {
-                        found = true;
-                        break;
-                    }
-                }
-                if (found || std::abs(z) > 2.0f) break;
-            }
-            mousePeriod = period;
-            mouseOrbit = orbit;
+            FractalView hoverView = displayedView;
+            hoverView.formulaIndex = formulaIndex;
+            hoverView.juliaMode = juliaMode;
+            hoverView.juliaC = std::complex<double>(juliaC.real(), juliaC.imag());
+            mousePeriod = findOrbitPeriod(hoverView, std::complex<double>(c.real(), c.imag()), maxOrbit, mouseOrbit);
         }
 
+        bool rendered = needsUpdate;
         if (needsUpdate) {
+            hud.enter(FrameHud::Compute);
             computeFractal(zoom, offset, juliaMode, juliaC, formulaIndex);
-            fractalTexture.loadFromImage(fractalImage);
-            fractalSprite.setTexture(fractalTexture, true);
+            hud.enter(FrameHud::Upload);
+            window->setFrame(rgba.data(), width, height);
             needsUpdate = false;
         }
 
-        window.clear();
-        window.draw(fractalSprite);
+        hud.enter(FrameHud::Overlay);
+        window->beginFrame();
 
         // Draw Julia point marker if in Julia mode
         if (juliaMode) {
             float x = juliaC.real() * zoom + width / 2.f - offset.x;
             float y = juliaC.imag() * zoom + height / 2.f - offset.y;
-            sf::CircleShape juliaMarker(8.f);
-            juliaMarker.setFillColor(sf::Color::Blue);
-            juliaMarker.setOrigin(8.f, 8.f);
             juliaMarker.setPosition(x, y);
-            window.draw(juliaMarker);
+            window->draw(juliaMarker);
         }
 
         // Show orbit and period on the mouse at all times
@@ -277,37 +398,43 @@ int main() {
             }
 
             // Draw a circle at the mouse position
-            sf::CircleShape marker(8.f);
-            marker.setFillColor(sf::Color::Red);
-            marker.setOrigin(8.f, 8.f);
             marker.setPosition(static_cast<float>(mouse.x), static_cast<float>(mouse.y));
-            window.draw(marker);
+            window->draw(marker);
 
             // Draw the orbit path
             if (mouseOrbit.size() > 1) {
-                sf::VertexArray orbitLine(sf::LineStrip, mouseOrbit.size());
+                orbitLine.resize(mouseOrbit.size()); // within the capacity reserved above
                 for (size_t i = 0; i < mouseOrbit.size(); ++i) {
                     float x = mouseOrbit[i].real() * zoom + width / 2.f - offset.x;
                     float y = mouseOrbit[i].imag() * zoom + height / 2.f - offset.y;
                     orbitLine[i].position = sf::Vector2f(x, y);
                     orbitLine[i].color = sf::Color::Green;
                 }
-                window.draw(orbitLine);
+                window->draw(orbitLine);
             }
 
             // Play a tone where period affects pitch (frequency) if left mouse is held (without ALT)
-            if (sf::Mouse::isButtonPressed(sf::Mouse::Left) &&
-                !(sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt) || sf::Keyboard::isKeyPressed(sf::Keyboard::RAlt))) {
+            if (window->isButtonPressed(sf::Mouse::Left) &&
+                !(window->isKeyPressed(sf::Keyboard::LAlt) || window->isKeyPressed(sf::Keyboard::RAlt))) {
+                hud.enter(FrameHud::Audio);
                 float freq = 220.0f + (mousePeriod % 40) * 10.0f; // Vary pitch by period
-                buffer = generateSineBuffer(44100, 0.08f, freq);
-                sound.setBuffer(buffer);
-                sound.play();
+                generateSineSamples(toneRate, toneSeconds, freq, toneSamples);
+                audio->play(toneSamples, toneRate);
+                hud.enter(FrameHud::Overlay);
             }
         } else {
             lastPeriod = -1;
         }
 
-        window.display();
+        heatmap.draw(*window);
+        hud.draw(*window);
+        hud.enter(FrameHud::Display);
+        window->display();
+        hud.endFrame();
+        stats.frameDisplayed(rendered);
     }
+    if (headless || args.has("record")) stats.print(std::cout);
+    if (args.has("report")) stats.writeJson(args.get("report", "session.json"));
+    if (args.has("trace") && !Trace::stop(args.get("trace", "trace.json"))) std::cerr << "Failed to write " << args.get("trace", "trace.json") << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,861 @@
+#include "Network.hpp"
+#include "Encoding.hpp"
+#include "Export.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <SFML/Network.hpp>
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+#include <zlib.h>
+
+// --- Tile farm (master / workers over TCP) ---
+//
+// The master keeps a queue of tiles and feeds each connected worker up to a
+// few tiles per render thread. Once the queue is empty, an idle worker steals
+// the most recently queued tile of the busiest worker (the victim is told to
+// drop it if it has not started). Tiles outstanding on a worker that
+// disconnects or goes silent are put back at the front of the queue.
+
+enum FarmMessage {
+    FarmHello = 1,  // worker -> master: threads
+    FarmTile = 2,   // master -> worker: tile id, view, rectangle
+    FarmCancel = 3, // master -> worker: tile id (stolen)
+    FarmResult = 4, // worker -> master: tile id, cost, zlib-compressed iterations
+    FarmDone = 5    // master -> worker: no more work
+};
+
+sf::Packet& operator<<(sf::Packet& packet, const FractalView& view) {
+    return packet << static_cast<sf::Int32>(view.width) << static_cast<sf::Int32>(view.height) << static_cast<sf::Int32>(view.maxIter)
+                  << static_cast<sf::Int32>(view.formulaIndex) << view.juliaMode << view.juliaC.real() << view.juliaC.imag()
+                  << view.center.real() << view.center.imag() << view.zoom << static_cast<sf::Uint8>(view.precision);
+}
+
+sf::Packet& operator>>(sf::Packet& packet, FractalView& view) {
+    sf::Int32 width = 0, height = 0, maxIter = 0, formulaIndex = 0;
+    double juliaRe = 0, juliaIm = 0, centerRe = 0, centerIm = 0;
+    sf::Uint8 precision = 0;
+    packet >> width >> height >> maxIter >> formulaIndex >> view.juliaMode >> juliaRe >> juliaIm >> centerRe >> centerIm >> view.zoom >> precision;
+    view.width = width;
+    view.height = height;
+    view.maxIter = maxIter;
+    view.formulaIndex = formulaIndex;
+    view.juliaC = std::complex<double>(juliaRe, juliaIm);
+    view.center = std::complex<double>(centerRe, centerIm);
+    view.precision = static_cast<Precision>(precision);
+    return packet;
+}
+
+sf::Packet& operator<<(sf::Packet& packet, const Tile& tile) {
+    return packet << static_cast<sf::Int32>(tile.x0) << static_cast<sf::Int32>(tile.y0) << static_cast<sf::Int32>(tile.x1) << static_cast<sf::Int32>(tile.y1);
+}
+
+sf::Packet& operator>>(sf::Packet& packet, Tile& tile) {
+    sf::Int32 x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    packet >> x0 >> y0 >> x1 >> y1;
+    tile = {x0, y0, x1, y1};
+    return packet;
+}
+
+// "host:port"
+bool parseHostPort(const std::string& text, sf::IpAddress& host, unsigned short& port) {
+    size_t colon = text.rfind(':');
+    if (colon == std::string::npos) return false;
+    host = sf::IpAddress(text.substr(0, colon));
+    port = static_cast<unsigned short>(std::stoi(text.substr(colon + 1)));
+    return host != sf::IpAddress::None;
+}
+
+// Connects to the master and renders tiles until told to stop. failAfter > 0
+// drops the connection after that many tiles, to exercise the master's retries.
+int farmWorkerLoop(const sf::IpAddress& host, unsigned short port, int threads, int failAfter) {
+    sf::TcpSocket socket;
+    if (socket.connect(host, port, sf::seconds(10)) != sf::Socket::Done) {
+        std::cerr << "Farm worker: cannot reach " << host.toString() << ":" << port << std::endl;
+        return 1;
+    }
+    sf::Packet hello;
+    hello << static_cast<sf::Uint8>(FarmHello) << static_cast<sf::Int32>(threads);
+    socket.send(hello);
+
+    struct TileJob {
+        sf::Int32 id;
+        FractalView view;
+        Tile tile;
+    };
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<TileJob> jobs;
+    bool stopping = false;
+    std::mutex sendMutex;
+    std::atomic<int> completed(0);
+
+    std::vector<std::thread> renderers;
+    for (int t = 0; t < threads; ++t) {
+        renderers.emplace_back([&]() {
+            std::vector<int> iterations;
+            std::vector<sf::Uint8> compressed;
+            for (;;) {
+                TileJob job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || !jobs.empty(); });
+                    if (stopping) return;
+                    job = jobs.front();
+                    jobs.pop_front();
+                }
+                int tileWidth = job.tile.x1 - job.tile.x0;
+                iterations.resize(static_cast<size_t>(tileWidth) * (job.tile.y1 - job.tile.y0));
+                uint64_t cost = renderTileInto(job.view, job.tile, iterations.data(), tileWidth);
+                uLongf compressedSize = compressBound(static_cast<uLong>(iterations.size() * sizeof(int)));
+                compressed.resize(compressedSize);
+                compress2(compressed.data(), &compressedSize, reinterpret_cast<const Bytef*>(iterations.data()),
+                          static_cast<uLong>(iterations.size() * sizeof(int)), 1);
+
+                sf::Packet result;
+                result << static_cast<sf::Uint8>(FarmResult) << job.id << static_cast<sf::Uint64>(cost) << static_cast<sf::Uint32>(compressedSize);
+                result.append(compressed.data(), compressedSize);
+                std::lock_guard<std::mutex> lock(sendMutex);
+                if (failAfter > 0 && completed >= failAfter) continue;
+                socket.send(result);
+                if (failAfter > 0 && ++completed >= failAfter) socket.disconnect();
+            }
+        });
+    }
+
+    sf::Packet packet;
+    while (socket.receive(packet) == sf::Socket::Done) {
+        sf::Uint8 type = 0;
+        packet >> type;
+        if (type == FarmTile) {
+            TileJob job;
+            packet >> job.id >> job.view >> job.tile;
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(job);
+            wake.notify_one();
+        } else if (type == FarmCancel) {
+            sf::Int32 id = -1;
+            packet >> id;
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [&](const TileJob& job) { return job.id == id; }), jobs.end());
+        } else if (type == FarmDone) {
+            break;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& renderer : renderers) renderer.join();
+    return 0;
+}
+
+// farm-worker --master HOST:PORT [--threads N] [--fail-after N]
+int runFarmWorker(const CommandLine& args) {
+    sf::IpAddress host;
+    unsigned short port;
+    if (!parseHostPort(args.get("master", "127.0.0.1:5555"), host, port)) {
+        std::cerr << "Bad --master address" << std::endl;
+        return 1;
+    }
+    return farmWorkerLoop(host, port, std::max(args.getInt("threads", renderThreadCount()), 1), args.getInt("fail-after", 0));
+}
+
+struct FarmWorkerState {
+    std::unique_ptr<sf::TcpSocket> socket;
+    std::string name;
+    int threads = 0;            // 0 until the worker has said hello
+    std::deque<int> outstanding; // tile ids sent and not yet returned
+    sf::Clock lastHeard;
+    int completed = 0;
+};
+
+// farm-master --out FILE.png [--port 5555] [--local-workers N] [--tile 64] [--prefetch 2] [--worker-timeout 30] [view options]
+int runFarmMaster(const CommandLine& args) {
+    FractalView view = viewFromCommandLine(args);
+    std::vector<Tile> tiles = makeTiles(view.width, view.height, std::max(args.getInt("tile", 64), 8));
+    int prefetch = std::max(args.getInt("prefetch", 2), 1);
+    float workerTimeout = static_cast<float>(args.getDouble("worker-timeout", 30.0));
+
+    sf::TcpListener listener;
+    if (listener.listen(static_cast<unsigned short>(args.getInt("port", 5555))) != sf::Socket::Done) {
+        std::cerr << "Farm master: cannot listen on port " << args.getInt("port", 5555) << std::endl;
+        return 1;
+    }
+    unsigned short port = listener.getLocalPort();
+    std::cout << "Farm master on port " << port << ", " << tiles.size() << " tiles" << std::endl;
+
+    // In-process workers over loopback share the cores between them
+    int localWorkers = args.getInt("local-workers", 0);
+    std::vector<std::thread> locals;
+    for (int i = 0; i < localWorkers; ++i) {
+        locals.emplace_back([=] { farmWorkerLoop(sf::IpAddress::LocalHost, port, std::max(renderThreadCount() / localWorkers, 1), 0); });
+    }
+
+    std::vector<int> iterations(static_cast<size_t>(view.width) * view.height);
+    std::vector<char> done(tiles.size(), 0);
+    std::deque<int> pending;
+    for (size_t i = 0; i < tiles.size(); ++i) pending.push_back(static_cast<int>(i));
+    size_t doneCount = 0;
+    uint64_t totalIterations = 0;
+    int retried = 0, stolen = 0;
+
+    std::vector<std::unique_ptr<FarmWorkerState>> workers;
+    sf::SocketSelector selector;
+    selector.add(listener);
+
+    auto send = [&](FarmWorkerState& worker, sf::Packet& packet) {
+        return worker.socket->send(packet) == sf::Socket::Done;
+    };
+    auto dropWorker = [&](size_t index, const char* reason) {
+        FarmWorkerState& worker = *workers[index];
+        int requeued = 0; // stolen tiles another worker finished are not sent again
+        for (auto it = worker.outstanding.rbegin(); it != worker.outstanding.rend(); ++it) {
+            if (!done[*it]) {
+                pending.push_front(*it);
+                ++requeued;
+            }
+        }
+        retried += requeued;
+        std::cout << "Worker " << worker.name << " " << reason << ", requeued " << requeued << " tile(s)" << std::endl;
+        selector.remove(*worker.socket);
+        workers.erase(workers.begin() + index);
+    };
+    auto sendTile = [&](FarmWorkerState& worker, int id) {
+        sf::Packet packet;
+        packet << static_cast<sf::Uint8>(FarmTile) << static_cast<sf::Int32>(id) << view << tiles[id];
+        worker.outstanding.push_back(id);
+        return send(worker, packet);
+    };
+
+    sf::Clock clock;
+    while (doneCount < tiles.size()) {
+        if (selector.wait(sf::milliseconds(100))) {
+            if (selector.isReady(listener)) {
+                std::unique_ptr<FarmWorkerState> worker(new FarmWorkerState());
+                worker->socket.reset(new sf::TcpSocket());
+                if (listener.accept(*worker->socket) == sf::Socket::Done) {
+                    worker->name = worker->socket->getRemoteAddress().toString() + ":" + std::to_string(worker->socket->getRemotePort());
+                    selector.add(*worker->socket);
+                    workers.push_back(std::move(worker));
+                }
+            }
+            for (size_t i = 0; i < workers.size(); ++i) {
+                FarmWorkerState& worker = *workers[i];
+                if (!selector.isReady(*worker.socket)) continue;
+                sf::Packet packet;
+                if (worker.socket->receive(packet) != sf::Socket::Done) {
+                    dropWorker(i--, "disconnected");
+                    continue;
+                }
+                worker.lastHeard.restart();
+                sf::Uint8 type = 0;
+                packet >> type;
+                if (type == FarmHello) {
+                    sf::Int32 threads = 1;
+                    packet >> threads;
+                    worker.threads = std::max<int>(threads, 1);
+                    std::cout << "Worker " << worker.name << " joined with " << worker.threads << " thread(s)" << std::endl;
+                } else if (type == FarmResult) {
+                    sf::Int32 id = -1;
+                    sf::Uint64 cost = 0;
+                    sf::Uint32 compressedSize = 0;
+                    packet >> id >> cost >> compressedSize;
+                    worker.outstanding.erase(std::remove(worker.outstanding.begin(), worker.outstanding.end(), id), worker.outstanding.end());
+                    if (id < 0 || id >= static_cast<int>(tiles.size()) || done[id] || packet.getDataSize() < compressedSize) continue;
+                    const Tile& tile = tiles[id];
+                    int tileWidth = tile.x1 - tile.x0;
+                    std::vector<int> tileIterations(static_cast<size_t>(tileWidth) * (tile.y1 - tile.y0));
+                    uLongf size = static_cast<uLongf>(tileIterations.size() * sizeof(int));
+                    const Bytef* data = static_cast<const Bytef*>(packet.getData()) + packet.getDataSize() - compressedSize;
+                    if (uncompress(reinterpret_cast<Bytef*>(tileIterations.data()), &size, data, compressedSize) != Z_OK) continue;
+                    for (int y = tile.y0; y < tile.y1; ++y) {
+                        std::copy_n(&tileIterations[static_cast<size_t>(y - tile.y0) * tileWidth], tileWidth,
+                                    &iterations[static_cast<size_t>(y) * view.width + tile.x0]);
+                    }
+                    done[id] = 1;
+                    ++doneCount;
+                    ++worker.completed;
+                    totalIterations += cost;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (!workers[i]->outstanding.empty() && workers[i]->lastHeard.getElapsedTime().asSeconds() > workerTimeout) {
+                dropWorker(i--, "timed out");
+            }
+        }
+
+        // Hand out queued tiles, then let idle workers steal from the busiest one
+        for (size_t i = 0; i < workers.size(); ++i) {
+            FarmWorkerState& worker = *workers[i];
+            if (worker.threads == 0) continue;
+            while (!pending.empty() && static_cast<int>(worker.outstanding.size()) < worker.threads * prefetch) {
+                int id = pending.front();
+                pending.pop_front();
+                if (done[id]) continue;
+                if (worker.outstanding.empty()) worker.lastHeard.restart();
+                if (!sendTile(worker, id)) break;
+            }
+            if (pending.empty() && worker.outstanding.empty()) {
+                FarmWorkerState* victim = nullptr;
+                for (auto& other : workers) {
+                    if (other->outstanding.size() > 1 && (!victim || other->outstanding.size() > victim->outstanding.size())) victim = other.get();
+                }
+                if (victim) {
+                    int id = victim->outstanding.back();
+                    victim->outstanding.pop_back();
+                    sf::Packet cancel;
+                    cancel << static_cast<sf::Uint8>(FarmCancel) << static_cast<sf::Int32>(id);
+                    send(*victim, cancel);
+                    worker.lastHeard.restart();
+                    sendTile(worker, id);
+                    ++stolen;
+                }
+            }
+        }
+    }
+
+    float seconds = clock.getElapsedTime().asSeconds();
+    for (auto& worker : workers) {
+        sf::Packet bye;
+        bye << static_cast<sf::Uint8>(FarmDone);
+        send(*worker, bye);
+        std::cout << "  " << worker->name << ": " << worker->completed << " tiles" << std::endl;
+    }
+    for (auto& local : locals) local.join();
+
+    std::cout << tiles.size() << " tiles in " << seconds << "s (" << totalIterations / 1e6 / std::max(seconds, 1e-6f)
+              << " Miter/s, " << retried << " retried, " << stolen << " stolen), hash " << formatHash(hashIterations(iterations)) << std::endl;
+    std::vector<sf::Uint8> rgba(iterations.size() * 4);
+    colourize(iterations.data(), iterations.size(), view.maxIter, 1, makePalette(args.get("palette", "grey")), rgba.data());
+    std::string path = args.get("out", "farm.png");
+    if (!writePngFile(path, rgba.data(), view.width, view.height, 0, viewTextChunks(view))) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// --- HTTP tile server ---
+//
+// GET /{formula}/{z}/{x}/{y}.png[?julia=re,im] serves 256x256 slippy-map tiles.
+// Zoom 0 is one tile covering [-2, 2] x [-2, 2]; each level doubles the tiles
+// per axis and adds --iter-per-zoom iterations.
+
+const int mapTileSize = 256;
+
+struct MapTileRequest {
+    int formula = 1;
+    int z = 0, x = 0, y = 0;
+    bool julia = false;
+    std::complex<double> juliaC;
+};
+
+// Path and query of a tile URL; false if it is not one
+bool parseMapTileUrl(const std::string& url, MapTileRequest& request) {
+    size_t query = url.find('?');
+    std::string path = url.substr(0, query);
+    int consumed = 0;
+    if (std::sscanf(path.c_str(), "/%d/%d/%d/%d.png%n", &request.formula, &request.z, &request.x, &request.y, &consumed) != 4 ||
+        consumed != static_cast<int>(path.size())) {
+        return false;
+    }
+    if (request.formula < 1 || request.formula > 4 || request.z < 0 || request.z > 40) return false;
+    long long tilesPerAxis = 1LL << request.z;
+    if (request.x < 0 || request.y < 0 || request.x >= tilesPerAxis || request.y >= tilesPerAxis) return false;
+    if (query != std::string::npos) {
+        size_t julia = url.find("julia=", query);
+        double re, im;
+        if (julia != std::string::npos && std::sscanf(url.c_str() + julia + 6, "%lf,%lf", &re, &im) == 2) {
+            request.julia = true;
+            request.juliaC = std::complex<double>(re, im);
+        }
+    }
+    return true;
+}
+
+FractalView mapTileView(const MapTileRequest& request, int baseMaxIter, int iterPerZoom) {
+    FractalView view;
+    view.width = view.height = mapTileSize;
+    view.formulaIndex = request.formula - 1;
+    view.juliaMode = request.julia;
+    view.juliaC = request.juliaC;
+    view.maxIter = baseMaxIter + iterPerZoom * request.z;
+    double tileSpan = 4.0 / static_cast<double>(1LL << request.z);
+    view.zoom = mapTileSize / tileSpan;
+    view.center = std::complex<double>(-2.0 + (request.x + 0.5) * tileSpan, -2.0 + (request.y + 0.5) * tileSpan);
+    return view;
+}
+
+bool sendAll(sf::TcpSocket& socket, const char* data, size_t size) {
+    return socket.send(data, size) == sf::Socket::Done;
+}
+
+// 'headers' are extra header lines, each ending in "\r\n"
+void sendHttpResponse(sf::TcpSocket& socket, const char* status, const std::string& contentType, const std::string& body, bool keepAlive,
+                      const std::string& headers = "") {
+    std::string head = std::string("HTTP/1.1 ") + status + "\r\n" + headers + "Content-Type: " + contentType +
+                       "\r\nContent-Length: " + std::to_string(body.size()) +
+                       "\r\nCache-Control: max-age=86400\r\nAccess-Control-Allow-Origin: *\r\nConnection: " +
+                       (keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+    sendAll(socket, head.data(), head.size()) && sendAll(socket, body.data(), body.size());
+}
+
+// serve [--port 8080] [--threads N] [--cache-tiles 4096] [--cache-dir DIR] [--max-iter 100] [--iter-per-zoom 20] [--palette P]
+int runTileServer(const CommandLine& args) {
+    sf::TcpListener listener;
+    unsigned short port = static_cast<unsigned short>(args.getInt("port", 8080));
+    if (listener.listen(port) != sf::Socket::Done) {
+        std::cerr << "Tile server: cannot listen on port " << port << std::endl;
+        return 1;
+    }
+    TaskPool pool(std::max(args.getInt("threads", renderThreadCount()), 1));
+    TileCache cache(static_cast<size_t>(args.getInt("cache-tiles", 4096)), args.get("cache-dir", ""));
+    Palette palette = makePalette(args.get("palette", "grey"));
+    int baseMaxIter = args.getInt("max-iter", 100);
+    int iterPerZoom = args.getInt("iter-per-zoom", 20);
+    std::atomic<int> connections(0);
+    std::cout << "Serving tiles on http://localhost:" << listener.getLocalPort() << "/{formula}/{z}/{x}/{y}.png with "
+              << pool.size() << " render threads" << std::endl;
+
+    auto renderTilePng = [&](const MapTileRequest& request) {
+        FractalView view = mapTileView(request, baseMaxIter, iterPerZoom);
+        std::vector<int> iterations(static_cast<size_t>(view.width) * view.height);
+        renderTileInto(view, Tile{0, 0, view.width, view.height}, iterations.data(), view.width);
+        std::vector<sf::Uint8> rgba(iterations.size() * 4), png;
+        colourize(iterations.data(), iterations.size(), view.maxIter, 1, palette, rgba.data());
+        encodePng(rgba.data(), view.width, view.height, png, 1);
+        return std::make_shared<const std::string>(png.begin(), png.end());
+    };
+
+    for (;;) {
+        std::shared_ptr<sf::TcpSocket> socket = std::make_shared<sf::TcpSocket>();
+        if (listener.accept(*socket) != sf::Socket::Done) continue;
+        // One thread per connection for I/O; the renders themselves go to the pool
+        ++connections;
+        std::thread([&, socket] {
+            std::string buffer;
+            char chunk[4096];
+            size_t received = 0;
+            bool keepAlive = true;
+            while (keepAlive) {
+                size_t end;
+                while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+                    if (buffer.size() > 16384 || socket->receive(chunk, sizeof(chunk), received) != sf::Socket::Done) {
+                        keepAlive = false;
+                        break;
+                    }
+                    buffer.append(chunk, received);
+                }
+                if (!keepAlive) break;
+                std::string head = buffer.substr(0, end);
+                buffer.erase(0, end + 4);
+                char method[16] = {}, url[2048] = {}, version[16] = {};
+                std::sscanf(head.c_str(), "%15s %2047s %15s", method, url, version);
+                std::string lowerHead = head;
+                std::transform(lowerHead.begin(), lowerHead.end(), lowerHead.begin(), ::tolower);
+                keepAlive = std::string(version) == "HTTP/1.1" && lowerHead.find("connection: close") == std::string::npos;
+
+                if (std::string(method) != "GET") {
+                    // Any request body is left unread, so the connection cannot be reused
+                    keepAlive = false;
+                    sendHttpResponse(*socket, "405 Method Not Allowed", "text/plain", "Only GET is supported\n", keepAlive, "Allow: GET\r\n");
+                    continue;
+                }
+                MapTileRequest request;
+                if (!parseMapTileUrl(url, request)) {
+                    sendHttpResponse(*socket, "404 Not Found", "text/plain", "Expected /{formula}/{z}/{x}/{y}.png[?julia=re,im]\n", keepAlive);
+                    continue;
+                }
+                std::ostringstream key;
+                key.precision(17);
+                key << request.formula << "/" << request.z << "/" << request.x << "/" << request.y;
+                if (request.julia) key << "_j" << request.juliaC.real() << "_" << request.juliaC.imag();
+                key << ".png";
+                TileCache::Blob png = cache.get(key.str(), [&renderTilePng, request] { return renderTilePng(request); }, &pool);
+                sendHttpResponse(*socket, "200 OK", "image/png", *png, keepAlive);
+            }
+            --connections;
+        }).detach();
+    }
+}
+
+// serve-bench [--server 127.0.0.1:8080] [--requests 2000] [--concurrency 16] [--zoom 4] [--formula 1]
+//
+// Keep-alive clients fetching random tiles of one zoom level; repeats hit the
+// cache, so run against a cold server to measure rendering throughput.
+int runTileServerBench(const CommandLine& args) {
+    sf::IpAddress host;
+    unsigned short port;
+    if (!parseHostPort(args.get("server", "127.0.0.1:8080"), host, port)) {
+        std::cerr << "Bad --server address" << std::endl;
+        return 1;
+    }
+    int requests = std::max(args.getInt("requests", 2000), 1);
+    int concurrency = std::max(args.getInt("concurrency", 16), 1);
+    int zoomLevel = std::min(std::max(args.getInt("zoom", 4), 0), 20);
+    int formula = args.getInt("formula", 1);
+
+    std::atomic<int> nextRequest(0), failures(0);
+    std::atomic<uint64_t> bytes(0);
+    std::mutex latencyMutex;
+    std::vector<float> latencies;
+    sf::Clock clock;
+    std::vector<std::thread> clients;
+    for (int c = 0; c < concurrency; ++c) {
+        clients.emplace_back([&, c] {
+            sf::TcpSocket socket;
+            bool connected = socket.connect(host, port, sf::seconds(5)) == sf::Socket::Done;
+            unsigned seed = 12345u + c;
+            std::string buffer;
+            char chunk[65536];
+            std::vector<float> local;
+            for (int r = nextRequest++; r < requests; r = nextRequest++) {
+                seed = seed * 1664525u + 1013904223u;
+                int x = static_cast<int>((seed >> 8) % (1u << zoomLevel));
+                seed = seed * 1664525u + 1013904223u;
+                int y = static_cast<int>((seed >> 8) % (1u << zoomLevel));
+                std::string get = "GET /" + std::to_string(formula) + "/" + std::to_string(zoomLevel) + "/" + std::to_string(x) + "/" +
+                                  std::to_string(y) + ".png HTTP/1.1\r\nHost: bench\r\n\r\n";
+                sf::Clock latency;
+                size_t received = 0, end = std::string::npos, length = 0;
+                if (connected && sendAll(socket, get.data(), get.size())) {
+                    while ((end = buffer.find("\r\n\r\n")) == std::string::npos &&
+                           socket.receive(chunk, sizeof(chunk), received) == sf::Socket::Done) {
+                        buffer.append(chunk, received);
+                    }
+                }
+                if (end == std::string::npos) {
+                    ++failures;
+                    connected = false;
+                    continue;
+                }
+                size_t field = buffer.find("Content-Length: ");
+                if (field != std::string::npos && field < end) length = std::stoul(buffer.substr(field + 16));
+                buffer.erase(0, end + 4);
+                while (buffer.size() < length && socket.receive(chunk, sizeof(chunk), received) == sf::Socket::Done) {
+                    buffer.append(chunk, received);
+                }
+                if (buffer.size() < length) {
+                    ++failures;
+                    connected = false;
+                    continue;
+                }
+                buffer.erase(0, length);
+                bytes += length;
+                local.push_back(latency.getElapsedTime().asSeconds() * 1000.f);
+            }
+            std::lock_guard<std::mutex> lock(latencyMutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        });
+    }
+    for (auto& client : clients) client.join();
+    float seconds = clock.getElapsedTime().asSeconds();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](float p) { return latencies.empty() ? 0.f : latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    std::cout << latencies.size() << " tiles in " << seconds << "s: " << latencies.size() / std::max(seconds, 1e-6f) << " req/s, "
+              << bytes / 1e6 / std::max(seconds, 1e-6f) << " MB/s, latency p50 " << percentile(0.5f) << "ms p95 "
+              << percentile(0.95f) << "ms p99 " << percentile(0.99f) << "ms, " << failures << " failed" << std::endl;
+    return failures > 0 ? 1 : 0;
+}
+
+// --- Remote frame streaming ---
+//
+// The server owns the view and sends iteration buffers, not pixels. Each frame
+// is the residual against the previous one; a pure pan is sent as a pixel move
+// so the residual is zero everywhere except the newly exposed strips, and the
+// server only renders those strips. The client colours frames itself and sends
+// its input events back.
+
+enum StreamMessage {
+    StreamFrame = 1, // server -> client: view, keyframe flag, move, hash, compressed residual
+    StreamInput = 2  // client -> server: one input event
+};
+
+enum StreamInputKind {
+    InputZoom = 1,     // x, y, wheel delta
+    InputPan = 2,      // dx, dy in pixels
+    InputFormula = 3,  // x = formula index
+    InputJulia = 4,    // x, y = Julia point
+    InputJuliaOff = 5
+};
+
+// previous shifted by (dx, dy); pixels shifted in from outside are 0
+void predictPannedFrame(const std::vector<int>& previous, int width, int height, int dx, int dy, std::vector<int>& predicted) {
+    predicted.assign(static_cast<size_t>(width) * height, 0);
+    if (previous.size() != predicted.size()) return;
+    for (int y = std::max(dy, 0); y < std::min(height, height + dy); ++y) {
+        int x0 = std::max(dx, 0), x1 = std::min(width, width + dx);
+        if (x1 <= x0) break;
+        std::copy(&previous[static_cast<size_t>(y - dy) * width + x0 - dx], &previous[static_cast<size_t>(y - dy) * width + x1 - dx],
+                  &predicted[static_cast<size_t>(y) * width + x0]);
+    }
+}
+
+// The viewer's socket is non-blocking: a send that is not ready, or only
+// partly done, is repeated with the same packet (which remembers how much
+// went out) until it is complete or the connection fails
+sf::Socket::Status sendStreamInput(sf::TcpSocket& socket, StreamInputKind kind, int x, int y, float delta) {
+    sf::Packet packet;
+    packet << static_cast<sf::Uint8>(StreamInput) << static_cast<sf::Uint8>(kind) << static_cast<sf::Int32>(x)
+           << static_cast<sf::Int32>(y) << delta;
+    sf::Socket::Status status;
+    while ((status = socket.send(packet)) == sf::Socket::Partial || status == sf::Socket::NotReady) sf::sleep(sf::milliseconds(1));
+    return status;
+}
+
+// stream-server [--port 5560] [view options]; serves one client at a time
+int runStreamServer(const CommandLine& args) {
+    sf::TcpListener listener;
+    unsigned short port = static_cast<unsigned short>(args.getInt("port", 5560));
+    if (listener.listen(port) != sf::Socket::Done) {
+        std::cerr << "Stream server: cannot listen on port " << port << std::endl;
+        return 1;
+    }
+    std::cout << "Streaming on port " << listener.getLocalPort() << std::endl;
+    const FractalView initialView = viewFromCommandLine(args);
+    const float zoomFactor = 1.2f;
+
+    for (;;) {
+        sf::TcpSocket client;
+        if (listener.accept(client) != sf::Socket::Done) continue;
+        std::cout << "Client " << client.getRemoteAddress().toString() << " connected" << std::endl;
+
+        FractalView view = initialView;
+        std::vector<int> sent, current, predicted, residual;
+        std::vector<sf::Uint8> compressed;
+        bool haveFrame = false, dirty = true;
+        int panX = 0, panY = 0;
+        uint64_t frames = 0, bytes = 0;
+        sf::SocketSelector selector;
+        selector.add(client);
+        bool connected = true;
+        while (connected) {
+            // Apply every queued event before rendering, so bursts collapse into one frame
+            while (connected && selector.wait(dirty ? sf::microseconds(1) : sf::milliseconds(100))) {
+                sf::Packet packet;
+                if (client.receive(packet) != sf::Socket::Done) {
+                    connected = false;
+                    break;
+                }
+                sf::Uint8 type = 0, kind = 0;
+                sf::Int32 x = 0, y = 0;
+                float delta = 0;
+                packet >> type >> kind >> x >> y >> delta;
+                if (type != StreamInput) continue;
+                if (kind == InputPan) {
+                    view.center -= std::complex<double>(x / view.zoom, y / view.zoom);
+                    panX += x;
+                    panY += y;
+                } else if (kind == InputZoom) {
+                    std::complex<double> anchor = pixelToComplex(view, x, y);
+                    view.zoom = delta > 0 ? view.zoom * zoomFactor : view.zoom / zoomFactor;
+                    view.center = anchor - std::complex<double>((x - view.width / 2.0) / view.zoom, (y - view.height / 2.0) / view.zoom);
+                    haveFrame = false;
+                } else if (kind == InputFormula) {
+                    view.formulaIndex = std::min(std::max<int>(x, 0), 3);
+                    haveFrame = false;
+                } else if (kind == InputJulia) {
+                    view.juliaMode = true;
+                    view.juliaC = pixelToComplex(view, x, y);
+                    haveFrame = false;
+                } else if (kind == InputJuliaOff) {
+                    view.juliaMode = false;
+                    haveFrame = false;
+                }
+                dirty = true;
+            }
+            if (!connected || !dirty) continue;
+
+            // A pure pan reuses the shifted previous frame and renders only what was exposed
+            bool move = haveFrame && std::abs(panX) < view.width && std::abs(panY) < view.height;
+            if (move) {
+                predictPannedFrame(sent, view.width, view.height, panX, panY, predicted);
+                current = predicted;
+                std::vector<Tile> exposed;
+                if (panX > 0) exposed.push_back({0, 0, panX, view.height});
+                if (panX < 0) exposed.push_back({view.width + panX, 0, view.width, view.height});
+                int x0 = std::max(panX, 0), x1 = std::min(view.width, view.width + panX);
+                if (panY > 0) exposed.push_back({x0, 0, x1, panY});
+                if (panY < 0) exposed.push_back({x0, view.height + panY, x1, view.height});
+                std::vector<int> order(exposed.size());
+                for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+                std::vector<uint64_t> costs;
+                renderTiles(view, current, exposed, order, renderThreadCount(), costs);
+            } else {
+                renderView(view, current);
+                predicted.assign(current.size(), 0);
+                panX = panY = 0;
+            }
+
+            residual.resize(current.size());
+            for (size_t i = 0; i < current.size(); ++i) residual[i] = current[i] - predicted[i];
+            uLongf compressedSize = compressBound(static_cast<uLong>(residual.size() * sizeof(int)));
+            compressed.resize(compressedSize);
+            compress2(compressed.data(), &compressedSize, reinterpret_cast<const Bytef*>(residual.data()),
+                      static_cast<uLong>(residual.size() * sizeof(int)), 1);
+
+            sf::Packet frame;
+            frame << static_cast<sf::Uint8>(StreamFrame) << view << !move << static_cast<sf::Int32>(move ? panX : 0)
+                  << static_cast<sf::Int32>(move ? panY : 0) << static_cast<sf::Uint64>(hashIterations(current))
+                  << static_cast<sf::Uint32>(compressedSize);
+            frame.append(compressed.data(), compressedSize);
+            if (client.send(frame) != sf::Socket::Done) break;
+            sent.swap(current);
+            haveFrame = true;
+            dirty = false;
+            panX = panY = 0;
+            ++frames;
+            bytes += frame.getDataSize();
+        }
+        std::cout << "Client left after " << frames << " frames, " << bytes / 1024 << " KiB ("
+                  << (frames ? bytes / frames : 0) << " bytes/frame)" << std::endl;
+    }
+}
+
+// Client side of the stream: rebuilds each iteration buffer from the residual
+struct StreamReceiver {
+    FractalView view;
+    std::vector<int> iterations, predicted;
+    uint64_t frames = 0, bytes = 0, mismatches = 0;
+
+    // False if the packet is not a well-formed frame
+    bool apply(sf::Packet& packet) {
+        sf::Uint8 type = 0;
+        bool keyframe = true;
+        sf::Int32 dx = 0, dy = 0;
+        sf::Uint64 hash = 0;
+        sf::Uint32 compressedSize = 0;
+        packet >> type >> view >> keyframe >> dx >> dy >> hash >> compressedSize;
+        if (type != StreamFrame || !packet || packet.getDataSize() < compressedSize) return false;
+        if (keyframe) {
+            predicted.assign(static_cast<size_t>(view.width) * view.height, 0);
+        } else {
+            predictPannedFrame(iterations, view.width, view.height, dx, dy, predicted);
+        }
+        iterations.resize(predicted.size());
+        uLongf size = static_cast<uLongf>(iterations.size() * sizeof(int));
+        const Bytef* data = static_cast<const Bytef*>(packet.getData()) + packet.getDataSize() - compressedSize;
+        if (uncompress(reinterpret_cast<Bytef*>(iterations.data()), &size, data, compressedSize) != Z_OK) return false;
+        for (size_t i = 0; i < iterations.size(); ++i) iterations[i] += predicted[i];
+        if (hashIterations(iterations) != hash) ++mismatches;
+        ++frames;
+        bytes += packet.getDataSize();
+        return true;
+    }
+};
+
+// stream-client --server HOST:PORT [--palette P] [--headless --frames N]
+//
+// Interactive: same controls as the explorer (wheel, ALT+drag, 1-4, hold J).
+// Headless: plays a scripted pan/zoom/formula sequence and reports bandwidth.
+int runStreamClient(const CommandLine& args) {
+    sf::IpAddress host;
+    unsigned short port;
+    if (!parseHostPort(args.get("server", "127.0.0.1:5560"), host, port)) {
+        std::cerr << "Bad --server address" << std::endl;
+        return 1;
+    }
+    sf::TcpSocket socket;
+    if (socket.connect(host, port, sf::seconds(5)) != sf::Socket::Done) {
+        std::cerr << "Cannot reach stream server " << host.toString() << ":" << port << std::endl;
+        return 1;
+    }
+    StreamReceiver receiver;
+    sf::Packet packet;
+    if (socket.receive(packet) != sf::Socket::Done || !receiver.apply(packet)) {
+        std::cerr << "No initial frame from server" << std::endl;
+        return 1;
+    }
+    const int width = receiver.view.width, height = receiver.view.height;
+    Palette palette = makePalette(args.get("palette", "grey"));
+    sf::Clock clock;
+
+    if (args.has("headless")) {
+        int frames = std::max(args.getInt("frames", 200), 1);
+        for (int f = 1; f < frames; ++f) {
+            if (f % 25 == 0) sendStreamInput(socket, InputZoom, width / 2 + 40, height / 2 - 30, 1.f);
+            else if (f == frames / 2) sendStreamInput(socket, InputFormula, 1, 0, 0.f);
+            else sendStreamInput(socket, InputPan, 6, -3, 0.f);
+            if (socket.receive(packet) != sf::Socket::Done || !receiver.apply(packet)) {
+                std::cerr << "Stream ended at frame " << f << std::endl;
+                return 1;
+            }
+        }
+    } else {
+        sf::RenderWindow window(sf::VideoMode(width, height), "Celtic Orbit Explorer (remote)");
+        sf::Image image;
+        image.create(width, height, sf::Color::Black);
+        sf::Texture texture;
+        sf::Sprite sprite;
+        std::vector<sf::Uint8> rgba;
+        bool dragging = false, julia = false, fresh = true;
+        sf::Vector2i lastMouse;
+        socket.setBlocking(false);
+        while (window.isOpen()) {
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                bool alt = sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt) || sf::Keyboard::isKeyPressed(sf::Keyboard::RAlt);
+                if (event.type == sf::Event::Closed) window.close();
+                if (event.type == sf::Event::MouseWheelScrolled && event.mouseWheelScroll.delta != 0) {
+                    sendStreamInput(socket, InputZoom, event.mouseWheelScroll.x, event.mouseWheelScroll.y, event.mouseWheelScroll.delta);
+                }
+                if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left && alt) {
+                    dragging = true;
+                    lastMouse = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+                }
+                if ((event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left) ||
+                    event.type == sf::Event::LostFocus) {
+                    dragging = false;
+                }
+                if (event.type == sf::Event::MouseMoved && dragging) {
+                    sf::Vector2i mouse(event.mouseMove.x, event.mouseMove.y);
+                    sendStreamInput(socket, InputPan, mouse.x - lastMouse.x, mouse.y - lastMouse.y, 0.f);
+                    lastMouse = mouse;
+                }
+                if (event.type == sf::Event::KeyPressed && event.key.code >= sf::Keyboard::Num1 && event.key.code <= sf::Keyboard::Num4) {
+                    sendStreamInput(socket, InputFormula, event.key.code - sf::Keyboard::Num1, 0, 0.f);
+                }
+            }
+            bool holdingJ = sf::Keyboard::isKeyPressed(sf::Keyboard::J);
+            if (holdingJ) {
+                sf::Vector2i mouse = sf::Mouse::getPosition(window);
+                if (!julia || mouse != lastMouse) sendStreamInput(socket, InputJulia, mouse.x, mouse.y, 0.f);
+                lastMouse = mouse;
+            } else if (julia) {
+                sendStreamInput(socket, InputJuliaOff, 0, 0, 0.f);
+            }
+            julia = holdingJ;
+
+            sf::Socket::Status status;
+            while ((status = socket.receive(packet)) == sf::Socket::Done) {
+                if (receiver.apply(packet)) fresh = true;
+            }
+            if (status == sf::Socket::Disconnected || status == sf::Socket::Error) window.close();
+            if (fresh) {
+                rgba.resize(receiver.iterations.size() * 4);
+                colourize(receiver.iterations.data(), receiver.iterations.size(), receiver.view.maxIter, 1, palette, rgba.data());
+                image.create(width, height, rgba.data());
+                texture.loadFromImage(image);
+                sprite.setTexture(texture, true);
+                fresh = false;
+            }
+            window.clear();
+            window.draw(sprite);
+            window.display();
+        }
+    }
+
+    float seconds = clock.getElapsedTime().asSeconds();
+    uint64_t rawBytes = receiver.frames * static_cast<uint64_t>(width) * height * 4;
+    std::cout << receiver.frames << " frames, " << receiver.bytes / 1024 << " KiB received (" << receiver.bytes / receiver.frames
+              << " bytes/frame, " << 100.0 * receiver.bytes / rawBytes << "% of raw RGBA), "
+              << receiver.frames / std::max(seconds, 1e-6f) << " frames/s, " << receiver.mismatches << " hash mismatches" << std::endl;
+    return receiver.mismatches > 0 ? 1 : 0;
+}
+
@@ -0,0 +1,12 @@
+#pragma once
+
+// Networked rendering: tile farm, HTTP tile server and remote frame streaming
+
+#include "CommandLine.hpp"
+
+int runFarmMaster(const CommandLine& args);
+int runFarmWorker(const CommandLine& args);
+int runTileServer(const CommandLine& args);
+int runTileServerBench(const CommandLine& args);
+int runStreamServer(const CommandLine& args);
+int runStreamClient(const CommandLine& args);
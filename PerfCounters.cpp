@@ -0,0 +1,99 @@
+#include "PerfCounters.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int openCounter(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1; // allowed at the default perf_event_paranoid level
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    // More counters than the PMU has are time-multiplexed; these let read() scale them back up
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+PerfCounters::PerfCounters() {
+    for (int& fd : fds) fd = -1;
+#ifdef __linux__
+    const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    fds[Cycles] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    int error = errno;
+    fds[Instructions] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[L1dMisses] = openCounter(PERF_TYPE_HW_CACHE, l1dReadMiss);
+    fds[LlcMisses] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fds[BranchMisses] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    if (!available()) {
+        why = std::string("perf_event_open: ") + std::strerror(error);
+        if (error == EACCES || error == EPERM) why += " (see /proc/sys/kernel/perf_event_paranoid)";
+        if (error == ENOENT || error == EOPNOTSUPP) why += " (no hardware counters exposed, e.g. in a virtual machine)";
+    }
+#else
+    why = "hardware counters need Linux perf_event_open";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+bool PerfCounters::available() const {
+    for (int fd : fds) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+PerfCounters::Sample PerfCounters::read() const {
+    Sample sample;
+#ifdef __linux__
+    for (int c = 0; c < CounterCount; ++c) {
+        uint64_t data[3]; // value, time enabled, time running
+        if (fds[c] < 0 || ::read(fds[c], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) continue;
+        sample.valid[c] = true;
+        sample.value[c] = data[2] > 0 && data[2] < data[1] ? static_cast<uint64_t>(double(data[0]) * data[1] / data[2]) : data[0];
+    }
+#endif
+    return sample;
+}
+
+PerfCounters::Sample PerfCounters::Sample::operator-(const Sample& earlier) const {
+    Sample delta;
+    for (int c = 0; c < CounterCount; ++c) {
+        delta.valid[c] = valid[c] && earlier.valid[c];
+        delta.value[c] = delta.valid[c] ? value[c] - earlier.value[c] : 0;
+    }
+    return delta;
+}
+
+bool PerfCounters::Sample::any() const {
+    for (bool v : valid) {
+        if (v) return true;
+    }
+    return false;
+}
+
+double PerfCounters::Sample::ipc() const {
+    if (!valid[Cycles] || !valid[Instructions] || value[Cycles] == 0) return 0;
+    return double(value[Instructions]) / value[Cycles];
+}
+
+const char* PerfCounters::name(Counter counter) {
+    static const char* names[CounterCount] = {"cycles", "instructions", "l1dMisses", "llcMisses", "branchMisses"};
+    return names[counter];
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// Hardware performance counters of this process (Linux perf_event_open):
+// cycles, instructions, L1 data and last-level cache misses and branch
+// mispredicts, in user space only. Threads started after the counters are
+// opened are counted too, so open them before any worker pool. Where the
+// kernel refuses (perf_event_paranoid, containers, other platforms) nothing
+// is counted and reason() says why; counters the CPU lacks are left out.
+
+#include <cstdint>
+#include <string>
+
+class PerfCounters {
+public:
+    enum Counter { Cycles, Instructions, L1dMisses, LlcMisses, BranchMisses, CounterCount };
+
+    // Totals since the counters were opened; valid[c] is false for counters that did not open
+    struct Sample {
+        bool valid[CounterCount] = {};
+        uint64_t value[CounterCount] = {};
+
+        Sample operator-(const Sample& earlier) const;
+        bool any() const;
+        // Instructions per cycle, 0 without both counters
+        double ipc() const;
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const;
+    const std::string& reason() const { return why; }
+
+    Sample read() const;
+
+    // JSON key of the counter
+    static const char* name(Counter counter);
+
+private:
+    int fds[CounterCount];
+    std::string why;
+};
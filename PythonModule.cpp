@@ -0,0 +1,245 @@
+// celticfractal: Python bindings for the fractal core
+//
+// Renders write straight into any writable C-contiguous int32 buffer (a NumPy
+// array, array.array, ...) and colouring into a uint8 one, so nothing is
+// copied on the way to NumPy. Both run with the GIL released on one shared
+// pool, so several Python threads can render at once.
+//
+//   import numpy as np, celticfractal as cf
+//   iterations = np.empty((600, 800), np.int32)
+//   cf.render(iterations, formula=2, julia=(-0.8, 0.15), zoom=300, max_iter=500, precision="float")
+//   rgb = np.asarray(cf.colourize(iterations, max_iter=500, palette="fire"))  # (600, 800, 4)
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "FractalCore.hpp"
+
+#include <cstring>
+#include <string>
+
+// Created on first use and never destroyed: its threads must not be joined while the interpreter shuts down
+static TaskPool* sharedPool() {
+    static TaskPool* pool = new TaskPool(renderThreadCount());
+    return pool;
+}
+
+// Shared view keywords; raises ValueError and returns false on bad values
+static bool fillView(FractalView& view, int formula, PyObject* julia, const char* precision) {
+    if (formula < 1 || formula > formulaCount) {
+        PyErr_Format(PyExc_ValueError, "formula must be 1-%d", formulaCount);
+        return false;
+    }
+    view.formulaIndex = formula - 1;
+    view.juliaMode = julia != Py_None;
+    if (view.juliaMode) {
+        Py_complex c = PyComplex_AsCComplex(julia);
+        if (PyErr_Occurred()) {
+            PyErr_Clear();
+            double re = 0, im = 0;
+            if (!PyArg_ParseTuple(julia, "dd", &re, &im)) {
+                PyErr_SetString(PyExc_ValueError, "julia must be a complex number or an (re, im) pair");
+                return false;
+            }
+            c.real = re;
+            c.imag = im;
+        }
+        view.juliaC = std::complex<double>(c.real, c.imag);
+    }
+    if (std::strcmp(precision, "float") == 0) {
+        view.precision = Precision::Float;
+    } else if (std::strcmp(precision, "double") == 0) {
+        view.precision = Precision::Double;
+    } else {
+        PyErr_SetString(PyExc_ValueError, "precision must be \"float\" or \"double\"");
+        return false;
+    }
+    return true;
+}
+
+// C-contiguous buffer of int32 (format 'i') or uint8 (format 'B') items; raises TypeError otherwise
+static bool getBuffer(PyObject* object, Py_buffer& buffer, Py_ssize_t itemSize, char format, bool writable) {
+    if (PyObject_GetBuffer(object, &buffer, (writable ? PyBUF_WRITABLE : 0) | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0) return false;
+    const char* f = buffer.format ? buffer.format : "B";
+    char code = f[std::strlen(f) - 1];
+    bool matches = buffer.itemsize == itemSize && (code == format || (format == 'i' && code == 'l' && sizeof(long) == 4));
+    if (!matches) {
+        PyErr_Format(PyExc_TypeError, "expected a buffer of %s", format == 'i' ? "int32" : "uint8");
+        PyBuffer_Release(&buffer);
+        return false;
+    }
+    return true;
+}
+
+// memoryview over a new bytearray, cast to the given format and shape
+static PyObject* newArray(const char* format, PyObject* shape, Py_ssize_t bytes) {
+    PyObject* storage = PyByteArray_FromStringAndSize(nullptr, bytes);
+    if (!storage) return nullptr;
+    PyObject* view = PyMemoryView_FromObject(storage);
+    Py_DECREF(storage);
+    if (!view) return nullptr;
+    PyObject* cast = PyObject_CallMethod(view, "cast", "sO", format, shape);
+    Py_DECREF(view);
+    return cast;
+}
+
+static PyObject* pyRender(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"out", "size", "formula", "julia", "center", "zoom", "max_iter", "precision", "kernel", nullptr};
+    PyObject* out = Py_None;
+    PyObject* julia = Py_None;
+    int width = 800, height = 600, formula = 1, maxIter = 100;
+    double centerRe = 0, centerIm = 0, zoom = 250;
+    const char* precision = "double";
+    const char* kernel = "scalar";
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O$(ii)iO(dd)diss", const_cast<char**>(keywords), &out, &width, &height,
+                                     &formula, &julia, &centerRe, &centerIm, &zoom, &maxIter, &precision, &kernel)) {
+        return nullptr;
+    }
+    FractalView view;
+    if (!fillView(view, formula, julia, precision)) return nullptr;
+    Kernel renderKernel = Kernel::Scalar;
+    if (std::strcmp(kernel, "reference") == 0) {
+        renderKernel = Kernel::Reference;
+    } else if (std::strcmp(kernel, "scalar") != 0) {
+        PyErr_SetString(PyExc_ValueError, "kernel must be \"scalar\" or \"reference\"");
+        return nullptr;
+    }
+    view.center = std::complex<double>(centerRe, centerIm);
+    view.zoom = zoom;
+    view.maxIter = maxIter;
+
+    if (out == Py_None) {
+        if (width <= 0 || height <= 0) {
+            PyErr_SetString(PyExc_ValueError, "size must be positive");
+            return nullptr;
+        }
+        PyObject* shape = Py_BuildValue("(ii)", height, width);
+        out = shape ? newArray("i", shape, static_cast<Py_ssize_t>(width) * height * sizeof(int)) : nullptr;
+        Py_XDECREF(shape);
+        if (!out) return nullptr;
+    } else {
+        Py_INCREF(out);
+    }
+    Py_buffer buffer;
+    if (!getBuffer(out, buffer, sizeof(int), 'i', true)) {
+        Py_DECREF(out);
+        return nullptr;
+    }
+    // A 2-D buffer gives the size; anything else must hold exactly 'size' pixels
+    if (buffer.ndim == 2) {
+        height = static_cast<int>(buffer.shape[0]);
+        width = static_cast<int>(buffer.shape[1]);
+    }
+    if (buffer.len != static_cast<Py_ssize_t>(width) * height * static_cast<Py_ssize_t>(sizeof(int))) {
+        PyErr_SetString(PyExc_ValueError, "out does not match size");
+        PyBuffer_Release(&buffer);
+        Py_DECREF(out);
+        return nullptr;
+    }
+    view.width = width;
+    view.height = height;
+
+    Py_BEGIN_ALLOW_THREADS
+    renderInto(view, renderKernel, static_cast<int*>(buffer.buf), width, sharedPool());
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&buffer);
+    return out;
+}
+
+static PyObject* pyColourize(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"iterations", "out", "max_iter", "palette", "iteration_scale", nullptr};
+    PyObject* iterations = nullptr;
+    PyObject* out = Py_None;
+    int maxIter = 100, iterationScale = 1;
+    const char* paletteName = "grey";
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O$isi", const_cast<char**>(keywords), &iterations, &out, &maxIter,
+                                     &paletteName, &iterationScale)) {
+        return nullptr;
+    }
+    if (maxIter <= 0 || iterationScale <= 0) {
+        PyErr_SetString(PyExc_ValueError, "max_iter and iteration_scale must be positive");
+        return nullptr;
+    }
+    Py_buffer source;
+    if (!getBuffer(iterations, source, sizeof(int), 'i', false)) return nullptr;
+    size_t count = static_cast<size_t>(source.len / sizeof(int));
+
+    if (out == Py_None) {
+        // Same shape as the iterations plus a channel axis
+        PyObject* shape = PyTuple_New(source.ndim + 1);
+        for (int d = 0; shape && d < source.ndim; ++d) PyTuple_SET_ITEM(shape, d, PyLong_FromSsize_t(source.shape[d]));
+        if (shape) PyTuple_SET_ITEM(shape, source.ndim, PyLong_FromLong(4));
+        out = shape ? newArray("B", shape, static_cast<Py_ssize_t>(count) * 4) : nullptr;
+        Py_XDECREF(shape);
+        if (!out) {
+            PyBuffer_Release(&source);
+            return nullptr;
+        }
+    } else {
+        Py_INCREF(out);
+    }
+    Py_buffer target;
+    if (!getBuffer(out, target, 1, 'B', true)) {
+        PyBuffer_Release(&source);
+        Py_DECREF(out);
+        return nullptr;
+    }
+    if (target.len != static_cast<Py_ssize_t>(count) * 4) {
+        PyErr_SetString(PyExc_ValueError, "out must hold 4 bytes per iteration count");
+        PyBuffer_Release(&target);
+        PyBuffer_Release(&source);
+        Py_DECREF(out);
+        return nullptr;
+    }
+    Palette palette = makePalette(paletteName);
+    Py_BEGIN_ALLOW_THREADS
+    colourize(static_cast<const int*>(source.buf), count, maxIter, iterationScale, palette, static_cast<uint8_t*>(target.buf));
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&target);
+    PyBuffer_Release(&source);
+    return out;
+}
+
+static PyObject* pyOrbitPeriod(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"c", "formula", "julia", "precision", "max_orbit", nullptr};
+    Py_complex c;
+    PyObject* julia = Py_None;
+    int formula = 1, maxOrbit = 1000;
+    const char* precision = "double";
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "D|$iOsi", const_cast<char**>(keywords), &c, &formula, &julia, &precision, &maxOrbit)) {
+        return nullptr;
+    }
+    FractalView view;
+    if (!fillView(view, formula, julia, precision)) return nullptr;
+    std::vector<std::complex<double>> orbit;
+    int period = 0;
+    Py_BEGIN_ALLOW_THREADS
+    period = findOrbitPeriod(view, std::complex<double>(c.real, c.imag), maxOrbit, orbit);
+    Py_END_ALLOW_THREADS
+    PyObject* points = PyList_New(static_cast<Py_ssize_t>(orbit.size()));
+    for (size_t i = 0; points && i < orbit.size(); ++i) {
+        PyList_SET_ITEM(points, static_cast<Py_ssize_t>(i), PyComplex_FromDoubles(orbit[i].real(), orbit[i].imag()));
+    }
+    return points ? Py_BuildValue("(iN)", period, points) : nullptr;
+}
+
+static PyMethodDef methods[] = {
+    {"render", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(pyRender)), METH_VARARGS | METH_KEYWORDS,
+     "render(out=None, *, size=(800, 600), formula=1, julia=None, center=(0.0, 0.0), zoom=250.0, max_iter=100,\n"
+     "       precision='double', kernel='scalar')\n"
+     "Iteration counts into out (int32, height x width) or a new buffer; returns it."},
+    {"colourize", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(pyColourize)), METH_VARARGS | METH_KEYWORDS,
+     "colourize(iterations, out=None, *, max_iter=100, palette='grey', iteration_scale=1)\n"
+     "Iteration counts to RGBA bytes (palette grey, fire or ocean); returns out or a new buffer."},
+    {"orbit_period", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(pyOrbitPeriod)), METH_VARARGS | METH_KEYWORDS,
+     "orbit_period(c, *, formula=1, julia=None, precision='double', max_orbit=1000)\n"
+     "(period, orbit points) of the point c, as shown when hovering in the explorer."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyModuleDef module = {PyModuleDef_HEAD_INIT, "celticfractal", "Celtic Orbit Explorer fractal core", -1, methods,
+                             nullptr, nullptr, nullptr, nullptr};
+
+PyMODINIT_FUNC PyInit_celticfractal() {
+    return PyModule_Create(&module);
+}
@@ -0,0 +1,189 @@
+#include "SessionStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+double LatencySamples::percentile(double p) const {
+    if (samples.empty()) return 0;
+    std::vector<double> sorted(samples);
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    size_t index = std::min(std::max<size_t>(rank, 1), sorted.size()) - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void LatencyHistogram::add(double ms) {
+    int bucket = 0;
+    while (bucket < bucketCount - 1 && ms > bucketLimit(bucket)) ++bucket;
+    ++buckets[bucket];
+    ++total;
+    largest = std::max(largest, ms);
+}
+
+double LatencyHistogram::bucketLimit(int bucket) {
+    return bucket < bucketCount - 1 ? double(1 << bucket) : 0;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(p / 100 * total)), 1), seen = 0;
+    for (int b = 0; b < bucketCount - 1; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return std::min(bucketLimit(b), largest);
+    }
+    return largest;
+}
+
+static double millisecondsBetween(SessionStats::Clock::time_point from, SessionStats::Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// Room for about 18 minutes at 60 Hz before the samples have to grow, so the
+// statistics themselves do not allocate in the loop they measure
+static const size_t reservedFrames = 1 << 16;
+
+SessionStats::SessionStats(double frameBudgetMs) : budgetMs(frameBudgetMs), start(Clock::now()), frameStart(start) {
+    frameMs.reserve(reservedFrames);
+    inputMs.reserve(reservedFrames);
+    pendingInputs.reserve(256);
+    pendingEffects.reserve(256);
+    for (LatencySamples& samples : effectMs) samples.reserve(reservedFrames);
+    if (Allocations::tracked()) {
+        allocationsPerFrame.reserve(reservedFrames);
+        bytesPerFrame.reserve(reservedFrames);
+    }
+    for (int s = 0; s < Allocations::maxSubsystems; ++s) startAllocations[s] = Allocations::total(s);
+    frameStartAllocations = Allocations::total();
+}
+
+const char* SessionStats::inputKindName(int kind) {
+    static const char* names[InputKindCount] = {"wheel", "drag", "julia", "formula"};
+    return kind >= 0 && kind < InputKindCount ? names[kind] : "";
+}
+
+void SessionStats::inputPolled() {
+    pendingInputs.push_back(Clock::now());
+}
+
+void SessionStats::viewInput(InputKind kind) {
+    pendingEffects.push_back({kind, Clock::now()});
+}
+
+void SessionStats::frameDisplayed(bool rendered) {
+    Clock::time_point now = Clock::now();
+    double ms = millisecondsBetween(frameStart, now);
+    frameMs.add(ms);
+    if (budgetMs > 0 && ms > budgetMs) dropped += static_cast<int>(std::ceil(ms / budgetMs)) - 1;
+    for (Clock::time_point polled : pendingInputs) inputMs.add(millisecondsBetween(polled, now));
+    pendingInputs.clear();
+    // Until a frame is rendered the view inputs have not shown yet
+    if (rendered) {
+        for (const PendingInput& input : pendingEffects) {
+            double latency = millisecondsBetween(input.polled, now);
+            effectMs[input.kind].add(latency);
+            effectHistograms[input.kind].add(latency);
+        }
+        pendingEffects.clear();
+    }
+    ++frameCount;
+    renders += rendered;
+    frameStart = now;
+    if (Allocations::tracked()) {
+        AllocationCounts total = Allocations::total(), frame = total - frameStartAllocations;
+        allocationsPerFrame.add(static_cast<double>(frame.allocations));
+        bytesPerFrame.add(static_cast<double>(frame.bytes));
+        allocatingFrames += frame.allocations > 0;
+        frameStartAllocations = total;
+    }
+}
+
+void SessionStats::print(std::ostream& out) const {
+    double seconds = millisecondsBetween(start, frameStart) / 1000;
+    out << frameCount << " frames (" << renders << " renders) in " << seconds << "s, "
+        << 1000 * seconds / std::max(frameCount, 1) << " ms/frame" << std::endl;
+    out << "frame time p50 " << frameMs.percentile(50) << " p95 " << frameMs.percentile(95) << " p99 " << frameMs.percentile(99)
+        << " max " << frameMs.max() << " ms; " << dropped << " dropped frames at " << budgetMs << " ms" << std::endl;
+    out << "input to display p50 " << inputMs.percentile(50) << " p95 " << inputMs.percentile(95) << " p99 "
+        << inputMs.percentile(99) << " max " << inputMs.max() << " ms over " << inputMs.count() << " inputs" << std::endl;
+    for (int k = 0; k < InputKindCount; ++k) {
+        const LatencySamples& samples = effectMs[k];
+        if (samples.count() == 0) continue;
+        out << "  " << inputKindName(k) << " to rendered display p50 " << samples.percentile(50) << " p95 " << samples.percentile(95)
+            << " p99 " << samples.percentile(99) << " max " << samples.max() << " ms over " << samples.count() << " inputs;";
+        const LatencyHistogram& histogram = effectHistograms[k];
+        for (int b = 0; b < LatencyHistogram::bucketCount; ++b) {
+            if (histogram.count(b) == 0) continue;
+            double limit = LatencyHistogram::bucketLimit(b);
+            if (limit > 0) out << " <=" << limit << "ms: " << histogram.count(b);
+            else out << " >" << LatencyHistogram::bucketLimit(b - 1) << "ms: " << histogram.count(b);
+        }
+        out << std::endl;
+    }
+    if (Allocations::tracked()) {
+        out << "allocations per frame p50 " << allocationsPerFrame.percentile(50) << " p99 " << allocationsPerFrame.percentile(99)
+            << " max " << allocationsPerFrame.max() << "; bytes per frame p50 " << bytesPerFrame.percentile(50) << " max "
+            << bytesPerFrame.max() << "; " << allocatingFrames << " of " << frameCount << " frames allocated" << std::endl;
+        for (int s = 0; s < Allocations::maxSubsystems; ++s) {
+            AllocationCounts spent = Allocations::total(s) - startAllocations[s];
+            if (spent.allocations == 0) continue;
+            out << "  " << Allocations::name(s) << ": " << double(spent.allocations) / std::max(frameCount, 1) << " allocations, "
+                << double(spent.bytes) / std::max(frameCount, 1) << " bytes per frame" << std::endl;
+        }
+    }
+    out << "peak resident set " << Allocations::peakResidentBytes() / (1024.0 * 1024.0) << " MB" << std::endl;
+}
+
+bool SessionStats::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    auto fields = [&](const LatencySamples& samples) {
+        out << "\"count\": " << samples.count() << ", \"p50\": " << samples.percentile(50) << ", \"p95\": " << samples.percentile(95)
+            << ", \"p99\": " << samples.percentile(99) << ", \"max\": " << samples.max();
+    };
+    auto distribution = [&](const LatencySamples& samples) {
+        out << "{";
+        fields(samples);
+        out << "}";
+    };
+    out << "{\n  \"frames\": " << frameCount << ",\n  \"renders\": " << renders << ",\n  \"seconds\": "
+        << millisecondsBetween(start, frameStart) / 1000 << ",\n  \"frameBudgetMs\": " << budgetMs
+        << ",\n  \"droppedFrames\": " << dropped << ",\n  \"frameMs\": ";
+    distribution(frameMs);
+    out << ",\n  \"inputLatencyMs\": ";
+    distribution(inputMs);
+    // Histogram buckets are {"upToMs": limit, "count": n}; the last one has no limit
+    out << ",\n  \"viewInputToDisplayMs\": {";
+    for (int k = 0; k < InputKindCount; ++k) {
+        out << (k ? ",\n" : "\n") << "    \"" << inputKindName(k) << "\": {";
+        fields(effectMs[k]);
+        out << ", \"histogram\": [";
+        const LatencyHistogram& histogram = effectHistograms[k];
+        for (int b = 0; b < LatencyHistogram::bucketCount; ++b) {
+            out << (b ? ", " : "") << "{";
+            if (LatencyHistogram::bucketLimit(b) > 0) out << "\"upToMs\": " << LatencyHistogram::bucketLimit(b) << ", ";
+            out << "\"count\": " << histogram.count(b) << "}";
+        }
+        out << "]}";
+    }
+    out << "\n  }";
+    if (Allocations::tracked()) {
+        out << ",\n  \"allocatingFrames\": " << allocatingFrames << ",\n  \"allocationsPerFrame\": ";
+        distribution(allocationsPerFrame);
+        out << ",\n  \"bytesPerFrame\": ";
+        distribution(bytesPerFrame);
+        out << ",\n  \"subsystems\": [";
+        bool first = true;
+        for (int s = 0; s < Allocations::maxSubsystems; ++s) {
+            AllocationCounts spent = Allocations::total(s) - startAllocations[s];
+            if (spent.allocations == 0) continue;
+            out << (first ? "\n" : ",\n") << "    {\"name\": \"" << Allocations::name(s) << "\", \"allocations\": " << spent.allocations
+                << ", \"bytes\": " << spent.bytes << "}";
+            first = false;
+        }
+        out << "\n  ]";
+    }
+    out << ",\n  \"peakResidentBytes\": " << Allocations::peakResidentBytes() << "\n}\n";
+    if (!out) std::cerr << "Failed to write " << path << std::endl;
+    return static_cast<bool>(out);
+}
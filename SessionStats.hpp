@@ -0,0 +1,94 @@
+#pragma once
+
+// Frame-time and input-latency statistics of an interactive session, for
+// recorded sessions replayed as a regression benchmark of the whole loop.
+// Inputs that change the view (wheel, drag, J, formula keys) are timed from
+// when they are polled to the display() of the first frame rendered after
+// them, the first one that shows their effect.
+// Allocation-tracking builds also get heap allocations per frame and per
+// subsystem; every build reports the peak resident set.
+
+#include "Allocations.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Millisecond (or any other) samples; percentiles by nearest rank
+class LatencySamples {
+public:
+    void add(double ms) { samples.push_back(ms); }
+    void reserve(size_t count) { samples.reserve(count); }
+    size_t count() const { return samples.size(); }
+    double percentile(double p) const; // p in [0, 100]; 0 when empty
+    double max() const { return percentile(100); }
+
+private:
+    std::vector<double> samples;
+};
+
+// Counts in power-of-two millisecond buckets: up to 1, 2, 4, ... 256 ms and
+// beyond. Cheap enough to add to and read every frame.
+class LatencyHistogram {
+public:
+    static constexpr int bucketCount = 10;
+
+    void add(double ms);
+    uint64_t count() const { return total; }
+    uint64_t count(int bucket) const { return buckets[bucket]; }
+    // Upper edge of the bucket, 0 for the open-ended last one
+    static double bucketLimit(int bucket);
+    // Upper edge of the bucket holding the p-th percentile (the largest sample for the last bucket)
+    double percentile(double p) const;
+
+private:
+    uint64_t buckets[bucketCount] = {};
+    uint64_t total = 0;
+    double largest = 0;
+};
+
+class SessionStats {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Frames taking longer than the budget count as dropped, one per budget missed
+    explicit SessionStats(double frameBudgetMs = 1000.0 / 60);
+
+    enum InputKind { Wheel, Drag, Julia, Formula, InputKindCount };
+    static const char* inputKindName(int kind);
+
+    // An input event was taken from the window's queue
+    void inputPolled();
+    // ... and it changes the view
+    void viewInput(InputKind kind);
+    // After display(): ends the frame and the latency of the inputs it handled
+    void frameDisplayed(bool rendered);
+
+    int frames() const { return frameCount; }
+    const LatencySamples& frameTimes() const { return frameMs; }
+    const LatencySamples& inputLatency() const { return inputMs; }
+    const LatencyHistogram& effectLatency(int kind) const { return effectHistograms[kind]; }
+
+    void print(std::ostream& out) const;
+    bool writeJson(const std::string& path) const;
+
+private:
+    double budgetMs;
+    Clock::time_point start, frameStart;
+    std::vector<Clock::time_point> pendingInputs;
+    LatencySamples frameMs, inputMs;
+    struct PendingInput {
+        InputKind kind;
+        Clock::time_point polled;
+    };
+    std::vector<PendingInput> pendingEffects;
+    LatencySamples effectMs[InputKindCount];
+    LatencyHistogram effectHistograms[InputKindCount];
+    int frameCount = 0, renders = 0, dropped = 0;
+    // Allocation totals when the session and the current frame started
+    AllocationCounts startAllocations[Allocations::maxSubsystems], frameStartAllocations;
+    LatencySamples allocationsPerFrame, bytesPerFrame;
+    int allocatingFrames = 0;
+};
@@ -0,0 +1,215 @@
+#include "SharedFrameRing.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint32_t ringMagic = 0x43464d52; // "RMFC"
+static const uint32_t ringVersion = 1;
+
+struct SharedFrameRing::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t reserved;
+    uint64_t maxPixels;
+    uint64_t slotStride;
+    alignas(64) std::atomic<uint64_t> published;
+};
+
+struct SharedFrameRing::Slot {
+    // Odd while the writer is inside the slot; 2 * (frame + 1) once frame is complete
+    alignas(64) std::atomic<uint64_t> sequence;
+    SharedFrameInfo info;
+    alignas(64) int iterations[1];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring needs address-free 64-bit atomics");
+
+FractalView SharedFrameInfo::view() const {
+    FractalView v;
+    v.width = width;
+    v.height = height;
+    v.maxIter = maxIter;
+    v.formulaIndex = formulaIndex;
+    v.juliaMode = juliaMode != 0;
+    v.precision = precision ? Precision::Float : Precision::Double;
+    v.juliaC = std::complex<double>(juliaRe, juliaIm);
+    v.center = std::complex<double>(centerRe, centerIm);
+    v.zoom = zoom;
+    return v;
+}
+
+static std::string shmName(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+SharedFrameRing::~SharedFrameRing() {
+#ifndef _WIN32
+    if (memory) munmap(memory, size);
+    // Readers that still have it mapped keep their mapping
+    if (owner) shm_unlink(name.c_str());
+#endif
+}
+
+std::unique_ptr<SharedFrameRing> SharedFrameRing::create(const std::string& name, int slots, size_t maxPixels) {
+#ifndef _WIN32
+    if (slots < 1 || maxPixels == 0) return nullptr;
+    std::unique_ptr<SharedFrameRing> ring(new SharedFrameRing());
+    ring->name = shmName(name);
+    ring->slotStride = (offsetof(Slot, iterations) + maxPixels * sizeof(int) + 63) / 64 * 64;
+    ring->size = sizeof(Header) + ring->slotStride * slots;
+
+    // A fresh object, so readers of a previous run do not see it change size under them
+    shm_unlink(ring->name.c_str());
+    int fd = shm_open(ring->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(ring->size)) != 0) {
+        std::cerr << "Cannot create shared memory " << ring->name << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(ring->name.c_str());
+        }
+        return nullptr;
+    }
+    void* memory = mmap(nullptr, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Cannot map shared memory " << ring->name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(ring->name.c_str());
+        return nullptr;
+    }
+    ring->memory = memory;
+    ring->owner = true;
+
+    // ftruncate zero-fills, so every sequence starts even and empty; the magic goes last
+    Header* header = new (memory) Header;
+    header->version = ringVersion;
+    header->slotCount = static_cast<uint32_t>(slots);
+    header->maxPixels = maxPixels;
+    header->slotStride = ring->slotStride;
+    header->published.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = ringMagic;
+    ring->header = header;
+    return ring;
+#else
+    (void)name;
+    (void)slots;
+    (void)maxPixels;
+    std::cerr << "Shared-memory frames need a POSIX system" << std::endl;
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<SharedFrameRing> SharedFrameRing::open(const std::string& name) {
+#ifndef _WIN32
+    std::unique_ptr<SharedFrameRing> ring(new SharedFrameRing());
+    ring->name = shmName(name);
+    int fd = shm_open(ring->name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "No shared frames at " << ring->name << std::endl;
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        std::cerr << ring->name << " is not a frame ring" << std::endl;
+        close(fd);
+        return nullptr;
+    }
+    ring->size = static_cast<size_t>(info.st_size);
+    // Read-only: a reader cannot disturb the writer even by accident
+    void* memory = mmap(nullptr, ring->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Cannot map shared memory " << ring->name << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    ring->memory = memory;
+    Header* header = static_cast<Header*>(memory);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->magic != ringMagic || header->version != ringVersion || header->slotCount == 0 ||
+        sizeof(Header) + header->slotStride * header->slotCount > ring->size) {
+        std::cerr << ring->name << " is not a frame ring of this version" << std::endl;
+        return nullptr;
+    }
+    ring->slotStride = header->slotStride;
+    ring->header = header;
+    return ring;
+#else
+    (void)name;
+    std::cerr << "Shared-memory frames need a POSIX system" << std::endl;
+    return nullptr;
+#endif
+}
+
+SharedFrameRing::Slot* SharedFrameRing::slot(uint64_t frame) const {
+    char* base = static_cast<char*>(memory) + sizeof(Header);
+    return reinterpret_cast<Slot*>(base + slotStride * (frame % header->slotCount));
+}
+
+int SharedFrameRing::slots() const {
+    return static_cast<int>(header->slotCount);
+}
+
+size_t SharedFrameRing::maxPixels() const {
+    return static_cast<size_t>(header->maxPixels);
+}
+
+uint64_t SharedFrameRing::published() const {
+    return header->published.load(std::memory_order_acquire);
+}
+
+bool SharedFrameRing::publish(const FractalView& view, const int* iterations, int iterationScale) {
+    size_t pixels = static_cast<size_t>(view.width) * view.height;
+    if (!owner || pixels > header->maxPixels) return false;
+    uint64_t frame = header->published.load(std::memory_order_relaxed);
+    Slot* target = slot(frame);
+
+    // Odd: readers inside this slot will see the change and drop what they read
+    uint64_t sequence = target->sequence.load(std::memory_order_relaxed);
+    target->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SharedFrameInfo& info = target->info;
+    info.frame = frame;
+    info.width = view.width;
+    info.height = view.height;
+    info.maxIter = view.maxIter;
+    info.formulaIndex = view.formulaIndex;
+    info.juliaMode = view.juliaMode;
+    info.precision = view.precision == Precision::Float;
+    info.iterationScale = iterationScale;
+    info.juliaRe = view.juliaC.real();
+    info.juliaIm = view.juliaC.imag();
+    info.centerRe = view.center.real();
+    info.centerIm = view.center.imag();
+    info.zoom = view.zoom;
+    std::memcpy(target->iterations, iterations, pixels * sizeof(int));
+
+    target->sequence.store(2 * (frame + 1), std::memory_order_release);
+    header->published.store(frame + 1, std::memory_order_release);
+    return true;
+}
+
+bool SharedFrameRing::read(uint64_t number, const std::function<void(const SharedFrameInfo&, const int*)>& visit) const {
+    const Slot* source = slot(number);
+    uint64_t expected = 2 * (number + 1);
+    if (source->sequence.load(std::memory_order_acquire) != expected) return false;
+    SharedFrameInfo info = source->info;
+    size_t pixels = static_cast<size_t>(info.width) * info.height;
+    if (info.width > 0 && info.height > 0 && pixels <= header->maxPixels) {
+        visit(info, source->iterations);
+    }
+    // Still the same frame after the visit, so nothing it saw was torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return source->sequence.load(std::memory_order_relaxed) == expected;
+}
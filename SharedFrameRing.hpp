@@ -0,0 +1,62 @@
+#pragma once
+
+// Completed frames (iteration counts plus their view) published into a POSIX
+// shared-memory ring for other local processes: recorders, dashboards, a
+// second viewer. Every slot carries a sequence counter (a seqlock): the writer
+// makes it odd while it overwrites the slot and even again once the frame is
+// complete. Readers look at the data in place and check afterwards that the
+// counter did not move, so the writer never waits for a reader; a reader
+// that falls behind just skips frames.
+
+#include "FractalCore.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// View of a published frame, as stored in the ring
+struct SharedFrameInfo {
+    uint64_t frame = 0; // number of frames published before this one
+    int32_t width = 0, height = 0, maxIter = 0, formulaIndex = 0;
+    int32_t juliaMode = 0, precision = 0, iterationScale = 1;
+    double juliaRe = 0, juliaIm = 0, centerRe = 0, centerIm = 0, zoom = 0;
+
+    FractalView view() const;
+};
+
+class SharedFrameRing {
+public:
+    ~SharedFrameRing();
+
+    // Writer side: replaces any ring of that name ("/name"); null on failure
+    static std::unique_ptr<SharedFrameRing> create(const std::string& name, int slots, size_t maxPixels);
+    // Reader side; null if there is no ring of that name
+    static std::unique_ptr<SharedFrameRing> open(const std::string& name);
+
+    // Copies the frame into the next slot; frames larger than the slots are dropped
+    bool publish(const FractalView& view, const int* iterations, int iterationScale = 1);
+
+    // Frames published so far
+    uint64_t published() const;
+    // Calls visit with frame 'number' in place, if it is still in the ring. False if
+    // it is not, or if the writer overwrote it during the visit (discard what was read).
+    bool read(uint64_t number, const std::function<void(const SharedFrameInfo&, const int*)>& visit) const;
+
+    int slots() const;
+    size_t maxPixels() const;
+
+private:
+    struct Header;
+    struct Slot;
+    SharedFrameRing() {}
+    Slot* slot(uint64_t frame) const;
+
+    std::string name;
+    bool owner = false;
+    void* memory = nullptr;
+    size_t size = 0;
+    size_t slotStride = 0;
+    Header* header = nullptr;
+};
@@ -0,0 +1,40 @@
+// celtictools: the headless commands, one per run
+
+#include "Export.hpp"
+#include "Network.hpp"
+#include "Trace.hpp"
+
+#include <iostream>
+#include <string>
+
+int runCommand(const std::string& command, const CommandLine& args) {
+    if (command == "render") return runRender(args);
+    if (command == "batch") return runBatch(args);
+    if (command == "zoom-video") return runZoomVideo(args);
+    if (command == "farm-master") return runFarmMaster(args);
+    if (command == "farm-worker") return runFarmWorker(args);
+    if (command == "serve") return runTileServer(args);
+    if (command == "serve-bench") return runTileServerBench(args);
+    if (command == "stream-server") return runStreamServer(args);
+    if (command == "stream-client") return runStreamClient(args);
+    if (command == "julia-morph") return runJuliaMorph(args);
+    if (command == "shm-read") return runSharedFrameReader(args);
+    std::cerr << "Unknown command: " << command << std::endl;
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: celtictools <render|batch|zoom-video|julia-morph|farm-master|farm-worker|serve|serve-bench|stream-server|stream-client|shm-read> [--options]" << std::endl;
+        return 1;
+    }
+    // --trace FILE.json records a timeline of any command
+    CommandLine args(argc, argv, 2);
+    if (args.has("trace")) Trace::start();
+    Trace::nameThread("main");
+    int status = runCommand(argv[1], args);
+    if (args.has("trace") && !Trace::stop(args.get("trace", "trace.json"))) {
+        std::cerr << "Failed to write " << args.get("trace", "trace.json") << std::endl;
+    }
+    return status;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+// Scoped timeline zones, written as trace-event JSON for Perfetto or
+// chrome://tracing. A zone costs one relaxed atomic load while no trace is
+// being recorded, and nothing at all when built with -DCELTIC_NO_TRACE.
+//
+//   TRACE_ZONE("tile");        // from here to the end of the scope
+//   Trace::start();  ...  Trace::stop("trace.json");
+//
+// Every thread appends to its own buffer, made on its first event while a
+// trace records. Buffers with events outlive their threads, so short-lived
+// render threads still show up in the file; the rest go when the thread ends.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Trace {
+public:
+    static bool enabled() { return state().enabled.load(std::memory_order_relaxed); }
+
+    // Microseconds since the trace started
+    static int64_t now() {
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        return (ns - state().epoch.load(std::memory_order_relaxed)) / 1000;
+    }
+
+    // A span measured elsewhere; 'name' must outlive the trace (a literal).
+    // Dropped unless a trace is recording.
+    static void record(const char* name, int64_t start, int64_t end) {
+        if (!enabled()) return;
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex); // only contended by stop()
+        buffer.events.push_back({name, start, end - start});
+    }
+
+    // Label for the calling thread's row on the timeline; a literal. Costs a
+    // thread-local store, so short-lived threads may call it freely.
+    static void nameThread(const char* name) {
+#ifndef CELTIC_NO_TRACE
+        ThreadSlot& slot = threadSlot();
+        slot.name = name;
+        if (slot.buffer) {
+            std::lock_guard<std::mutex> lock(slot.buffer->mutex);
+            slot.buffer->name = name;
+        }
+#else
+        (void)name;
+#endif
+    }
+
+    static void start() {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (auto& thread : s.threads) {
+            std::lock_guard<std::mutex> events(thread->mutex);
+            thread->events.clear();
+        }
+        s.epoch.store(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        s.enabled.store(true);
+    }
+
+    // Stops recording and writes everything recorded since start()
+    static bool stop(const std::string& path) {
+        State& s = state();
+        s.enabled.store(false);
+        std::ofstream out(path);
+        out << "{\"traceEvents\": [\n";
+        bool first = true;
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (auto& thread : s.threads) {
+            std::lock_guard<std::mutex> events(thread->mutex);
+            if (thread->name && !thread->events.empty()) {
+                out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->id
+                    << ", \"args\": {\"name\": \"" << thread->name << "\"}}";
+                first = false;
+            }
+            for (const Event& event : thread->events) {
+                out << (first ? "" : ",\n") << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->id
+                    << ", \"ts\": " << event.start << ", \"dur\": " << event.duration << "}";
+                first = false;
+            }
+            thread->events.clear();
+        }
+        // Written out, so the buffers of threads that have ended can go
+        s.threads.erase(std::remove_if(s.threads.begin(), s.threads.end(),
+                                       [](const std::shared_ptr<ThreadBuffer>& thread) { return thread->finished; }),
+                        s.threads.end());
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+
+private:
+    struct Event {
+        const char* name;
+        int64_t start, duration;
+    };
+    struct ThreadBuffer {
+        int id = 0;
+        const char* name = nullptr;
+        bool finished = false; // guarded by the state's mutex
+        std::mutex mutex;
+        std::vector<Event> events;
+    };
+    struct State {
+        std::atomic<bool> enabled{false};
+        std::atomic<int64_t> epoch{0};
+        std::atomic<int> nextId{1};
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    };
+    // The thread's name, and its buffer once it has recorded something. A thread
+    // that ends takes its buffer off the list, or leaves it for stop() to write.
+    struct ThreadSlot {
+        const char* name = nullptr;
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~ThreadSlot() {
+            if (!buffer) return;
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            std::lock_guard<std::mutex> events(buffer->mutex);
+            if (buffer->events.empty()) s.threads.erase(std::find(s.threads.begin(), s.threads.end(), buffer));
+            else buffer->finished = true;
+        }
+    };
+
+    static State& state() {
+        static State s;
+        return s;
+    }
+    static ThreadSlot& threadSlot() {
+        thread_local ThreadSlot slot;
+        return slot;
+    }
+    // Registered on the thread's first event
+    static ThreadBuffer& threadBuffer() {
+        ThreadSlot& slot = threadSlot();
+        if (!slot.buffer) {
+            auto created = std::make_shared<ThreadBuffer>();
+            State& s = state();
+            created->id = s.nextId++;
+            created->name = slot.name;
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.threads.push_back(created);
+            slot.buffer = created;
+        }
+        return *slot.buffer;
+    }
+};
+
+// Records its lifetime as one span when a trace is running
+class TraceZone {
+public:
+    explicit TraceZone(const char* name) : name(Trace::enabled() ? name : nullptr), start(this->name ? Trace::now() : 0) {}
+    ~TraceZone() {
+        if (name) Trace::record(name, start, Trace::now());
+    }
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#ifdef CELTIC_NO_TRACE
+#define TRACE_ZONE(name) ((void)0)
+#else
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#endif